@@ -0,0 +1,80 @@
+/*
+* Many games at once in one process: all of them started together on one
+* io_service, their searches queued on a compute pool. Reports how many
+* moves and games per second the pool gets through and how long a game
+* waits for a move. Every player has a transposition table of its own of
+* ComputePool::DEFAULT_PLAYER_HASH_MB.
+*
+* usage: benchmark_async_games [games [depth [compute_threads [io_threads [max_plies]]]]]
+*/
+#include "asyncgame.h"
+#include "asyncaiplayer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+int main(int argc, char * argv[])
+{
+    int games_count = argc > 1 ? atoi(argv[1]) : 1000;
+    int depth = argc > 2 ? atoi(argv[2]) : 2;
+    int compute_threads = argc > 3 ? atoi(argv[3]) : max<int>(thread::hardware_concurrency(), 1);
+    int io_threads = argc > 4 ? atoi(argv[4]) : 2;
+    int max_plies = argc > 5 ? atoi(argv[5]) : 40;
+
+    auto io = make_shared<boost::asio::io_service>();
+    auto pool = make_shared<ComputePool>(compute_threads);
+    auto metrics = make_shared<GameMetrics>();
+
+    atomic<int> results[4];
+    for (atomic<int> & result : results)
+        result = 0;
+    atomic<int> running(games_count);
+
+    vector<unique_ptr<AsyncGame>> games;
+    for (int i = 0; i < games_count; i++) {
+        games.emplace_back(new AsyncGame(io, make_shared<AsyncAiPlayer>(WHITE, depth, pool),
+                                         make_shared<AsyncAiPlayer>(BLACK, depth, pool)));
+        games.back()->setMaxPlies(max_plies);
+        games.back()->setMetrics(metrics);
+    }
+    for (unique_ptr<AsyncGame> & game : games) {
+        game->start([&results, &running, io](AsyncPlayer::EndStatus status) {
+            results[status]++;
+            if (--running == 0)
+                io->stop();
+        });
+    }
+
+    vector<thread> threads;
+    for (int i = 0; i < io_threads; i++) {
+        threads.emplace_back([io]() {
+            io->run();
+        });
+    }
+    for (thread & io_thread : threads)
+        io_thread.join();
+
+    double seconds = chrono::duration<double>(GameMetrics::Clock::now() - metrics->start).count();
+    const LatencyMeasurement & latency = metrics->move_latency;
+    cout << games_count << " games, depth " << depth << ", " << compute_threads << " compute threads, "
+         << io_threads << " io threads, at most " << max_plies << " plies" << endl;
+    cout << fixed << setprecision(2)
+         << "time s          " << seconds << endl
+         << "games/s         " << metrics->gamesPerSecond() << endl
+         << "moves/s         " << metrics->movesPerSecond() << endl
+         << "moves           " << metrics->moves << endl
+         << "white/draw/black " << results[AsyncPlayer::WHITE_WIN] << "/" << results[AsyncPlayer::DRAW]
+         << "/" << results[AsyncPlayer::WHITE_LOOSE] << endl
+         << "move latency ms mean " << latency.mean().count() / 1000.0
+         << ", p50 " << latency.percentile(0.5).count() / 1000.0
+         << ", p99 " << latency.percentile(0.99).count() / 1000.0
+         << ", max " << latency.max().count() / 1000.0 << endl;
+    return 0;
+}
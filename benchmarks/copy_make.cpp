@@ -0,0 +1,103 @@
+/*
+* Two ways to walk a tree: ChessBoard::move() and undoMove() on one board
+* against copy-make of CompactPosition (copy the parent, make the move on
+* the copy). The moves of two plies are generated beforehand, only making and
+* taking them back is timed.
+*
+* usage: benchmark_copy_make [rounds]
+*/
+#include "chessboard.h"
+#include "compactposition.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+static const char * positions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+};
+
+struct Line {
+    Move move;
+    MoveList replies;
+};
+
+typedef chrono::steady_clock Clock;
+
+int main(int argc, char * argv[])
+{
+    int rounds = argc > 1 ? atoi(argv[1]) : 2000;
+
+    cout << "sizeof(ChessBoard) " << sizeof(ChessBoard) << ", sizeof(CompactPosition) " << sizeof(CompactPosition) << endl;
+    cout << setw(12) << "strategy" << setw(12) << "moves" << setw(12) << "time ms" << setw(12) << "ns/move" << endl;
+
+    Clock::duration make_undo(0), copy_make(0);
+    unsigned long long moves_made = 0;
+    // keeps the compiler from dropping the work
+    uint64_t checksum = 0;
+
+    for (const char * fen : positions) {
+        ChessBoard board;
+        board.loadFEN(fen);
+        vector<Line> lines;
+        MoveList moves;
+        MoveGenerator<false>::getMoves(board, board.next_move_color, moves, moves);
+        for (Move & move : moves) {
+            lines.push_back(Line{move, MoveList()});
+            board.move(move);
+            MoveGenerator<false>::getMoves(board, board.next_move_color, lines.back().replies, lines.back().replies);
+            board.undoMove(move);
+        }
+        unsigned long long position_moves = 0;
+        for (const Line & line : lines)
+            position_moves += 1 + line.replies.size();
+        moves_made += position_moves * rounds;
+
+        Clock::time_point start = Clock::now();
+        for (int round = 0; round < rounds; round++) {
+            for (Line & line : lines) {
+                board.move(line.move);
+                for (Move & reply : line.replies) {
+                    board.move(reply);
+                    checksum += board.hash;
+                    board.undoMove(reply);
+                }
+                board.undoMove(line.move);
+            }
+        }
+        make_undo += Clock::now() - start;
+
+        const CompactPosition root = CompactPosition::fromBoard(board);
+        start = Clock::now();
+        for (int round = 0; round < rounds; round++) {
+            for (Line & line : lines) {
+                CompactPosition child = root;
+                child.makeMove(line.move);
+                for (Move & reply : line.replies) {
+                    CompactPosition grandchild = child;
+                    grandchild.makeMove(reply);
+                    checksum -= grandchild.hash;
+                }
+            }
+        }
+        copy_make += Clock::now() - start;
+    }
+
+    auto print = [moves_made](const char * name, Clock::duration time) {
+        double ns = chrono::duration_cast<chrono::nanoseconds>(time).count();
+        cout << setw(12) << name << setw(12) << moves_made << setw(12) << fixed << setprecision(1) << ns / 1e6
+             << setw(12) << setprecision(2) << ns / moves_made << endl;
+    };
+    print("make/undo", make_undo);
+    print("copy-make", copy_make);
+    // both walks visit the same positions
+    return checksum == 0 ? 0 : 1;
+}
@@ -0,0 +1,68 @@
+/*
+* Time to depth of the parallel search for 1, 2, 4 ... threads.
+*
+* usage: benchmark_parallel_search [depth [max_threads [lazy|ybwc]]]
+*/
+#include "chessboard.h"
+#include "aiplayer.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+static const char * positions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+};
+
+int main(int argc, char * argv[])
+{
+    int depth = argc > 1 ? atoi(argv[1]) : 5;
+    int max_threads = argc > 2 ? atoi(argv[2]) : 32;
+    AIPlayer::ParallelMode mode = argc > 3 && string(argv[3]) == "ybwc"
+            ? AIPlayer::YoungBrothersWait : AIPlayer::LazySmp;
+
+    cout << (mode == AIPlayer::LazySmp ? "lazy smp" : "young brothers wait")
+         << ", depth " << depth << ", " << thread::hardware_concurrency()
+         << " hardware threads" << endl;
+    cout << setw(8) << "threads" << setw(12) << "time ms" << setw(10) << "speedup"
+         << setw(14) << "nodes" << setw(12) << "knps" << endl;
+
+    double single_thread_ms = 0;
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        chrono::microseconds total(0);
+        unsigned long long nodes = 0;
+
+        for (const char * fen : positions) {
+            ChessBoard board;
+            board.loadFEN(fen);
+
+            // a fresh table for every run, so no run profits from the one before
+            AIPlayer player(board.next_move_color, depth);
+            player.setThreads(threads);
+            player.setParallelMode(mode);
+
+            Move move;
+            AdvancedMoveData advanced;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            player.getMove(board, move, &advanced);
+            total += chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start);
+            nodes += advanced.nodes;
+        }
+
+        double ms = total.count() / 1000.0;
+        if (threads == 1)
+            single_thread_ms = ms;
+        cout << setw(8) << threads << setw(12) << fixed << setprecision(1) << ms
+             << setw(10) << setprecision(2) << single_thread_ms / ms
+             << setw(14) << nodes << setw(12) << setprecision(0) << nodes / ms << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,112 @@
+/*
+* Move generator node counts and speed.
+*
+* usage: perft                      built-in suite, expected counts checked
+*        perft suite [max_depth]
+*        perft "<fen>" depth [divide]
+*/
+#include "chessboard.h"
+#include "perft.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// Deepest default suite depth, keeps the suite around a few seconds
+static const int DEFAULT_SUITE_DEPTH = 5;
+static const unsigned long long SUITE_NODE_LIMIT = 20000000;
+
+static void printHeader()
+{
+    cout << setw(6) << "depth" << setw(14) << "nodes" << setw(12) << "captures"
+         << setw(8) << "e.p." << setw(10) << "castles" << setw(8) << "promo"
+         << setw(10) << "checks" << setw(10) << "ms" << setw(8) << "Mnps" << endl;
+}
+
+static void printCounters(int depth, const PerftCounters & counters, chrono::microseconds time)
+{
+    cout << setw(6) << depth << setw(14) << counters.nodes << setw(12) << counters.captures
+         << setw(8) << counters.en_passants << setw(10) << counters.castles
+         << setw(8) << counters.promotions << setw(10) << counters.checks
+         << setw(10) << time.count() / 1000
+         << setw(8) << fixed << setprecision(2)
+         << (time.count() ? double(counters.nodes) / time.count() : 0.0) << endl;
+}
+
+static int runSuite(int max_depth)
+{
+    int failures = 0;
+    unsigned long long total_nodes = 0;
+    chrono::microseconds total_time(0);
+
+    for (const Perft::Position & position : Perft::suite()) {
+        ChessBoard board;
+        board.loadFEN(position.fen);
+        cout << position.name << ": " << position.fen << endl;
+        printHeader();
+
+        for (int depth = 1; depth <= max_depth && depth <= int(position.nodes.size()); depth++) {
+            // the deep counts of some positions take minutes
+            if (depth > 1 && position.nodes[depth - 1] > SUITE_NODE_LIMIT && max_depth == DEFAULT_SUITE_DEPTH)
+                break;
+
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            PerftCounters counters = Perft::run(board, depth);
+            chrono::microseconds time = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start);
+            printCounters(depth, counters, time);
+
+            total_nodes += counters.nodes;
+            total_time += time;
+            if (counters.nodes != position.nodes[depth - 1]) {
+                cout << "FAILED: expected " << position.nodes[depth - 1] << " nodes" << endl;
+                failures++;
+            }
+        }
+        cout << endl;
+    }
+
+    cout << "total " << total_nodes << " nodes in " << total_time.count() / 1000 << " ms, "
+         << fixed << setprecision(2) << double(total_nodes) / max<long long>(total_time.count(), 1)
+         << " Mnps" << endl;
+    cout << (failures ? "FAILED" : "all counts match") << endl;
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char * argv[])
+{
+    if (argc < 2)
+        return runSuite(DEFAULT_SUITE_DEPTH);
+    if (string(argv[1]) == "suite")
+        return runSuite(argc > 2 ? atoi(argv[2]) : DEFAULT_SUITE_DEPTH);
+
+    ChessBoard board;
+    try {
+        board.loadFEN(argv[1]);
+    } catch (const exception & e) {
+        cerr << "Bad FEN: " << e.what() << endl;
+        return 1;
+    }
+    int depth = argc > 2 ? atoi(argv[2]) : 1;
+    bool divide = argc > 3 && string(argv[3]) == "divide";
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    PerftCounters counters;
+    if (divide) {
+        for (const auto & root : Perft::divide(board, depth)) {
+            cout << root.first.toString() << ": " << root.second.nodes << endl;
+            counters += root.second;
+        }
+        cout << endl;
+    } else {
+        counters = Perft::run(board, depth);
+    }
+    chrono::microseconds time = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start);
+
+    printHeader();
+    printCounters(depth, counters, time);
+    return 0;
+}
@@ -0,0 +1,143 @@
+/*
+* Selective search techniques one by one: nodes and time to a fixed depth
+* with each of them switched off, then games at a fixed time per move
+* against the search without any of them.
+*
+* usage: benchmark_pruning [depth [games_per_opening [move_ms]]]
+*/
+#include "chessboard.h"
+#include "aiplayer.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static const char * positions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+};
+
+// Balanced openings the games start from, each played with both colors
+static const char * openings[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+    "rnbqkb1r/pp2pppp/3p1n2/8/3NP3/8/PPP2PPP/RNBQKB1R w KQkq - 1 5",
+    "rnbqkb1r/ppp1pppp/5n2/3p4/2PP4/8/PP2PPPP/RNBQKBNR w KQkq - 1 3",
+};
+
+// Games still going on after this many moves count as draws
+static const int MAX_GAME_PLIES = 200;
+
+struct Configuration {
+    const char * name;
+    int pruning;
+};
+
+static const Configuration configurations[] = {
+    {"all",                  AIPlayer::AllPruning},
+    {"no null move",         AIPlayer::AllPruning & ~AIPlayer::NullMove},
+    {"no lmr",               AIPlayer::AllPruning & ~AIPlayer::LateMoveReductions},
+    {"no futility",          AIPlayer::AllPruning & ~AIPlayer::Futility},
+    {"no reverse futility",  AIPlayer::AllPruning & ~AIPlayer::ReverseFutility},
+    {"none",                 0},
+};
+
+/*
+* 1 if white wins, 0 if black wins, 0.5 for a draw
+*/
+static double playGame(const char * fen, int white_pruning, int black_pruning, chrono::milliseconds move_time)
+{
+    ChessBoard board;
+    board.loadFEN(fen);
+    AIPlayer white(WHITE, MAX_SEARCH_DEPTH), black(BLACK, MAX_SEARCH_DEPTH);
+    white.setPruning(white_pruning);
+    black.setPruning(black_pruning);
+    white.setMoveTime(move_time);
+    black.setMoveTime(move_time);
+
+    for (int ply = 0; ply < MAX_GAME_PLIES; ply++) {
+        switch (board.getPlayerStatus(board.next_move_color)) {
+            case ChessPlayer::Checkmate:
+                return board.next_move_color == WHITE ? 0 : 1;
+            case ChessPlayer::Stalemate:
+            case ChessPlayer::Draw:
+                return 0.5;
+            default:
+                break;
+        }
+        AIPlayer & player = board.next_move_color == WHITE ? white : black;
+        Move move;
+        // no move means the player gives up
+        if (NOT player.getMove(board, move))
+            return board.next_move_color == WHITE ? 0 : 1;
+        board.move(move);
+    }
+    return 0.5;
+}
+
+static double eloDifference(double score)
+{
+    score = min(max(score, 0.01), 0.99);
+    return -400 * log10(1 / score - 1);
+}
+
+int main(int argc, char * argv[])
+{
+    int depth = argc > 1 ? atoi(argv[1]) : 6;
+    int games_per_opening = argc > 2 ? atoi(argv[2]) : 2;
+    chrono::milliseconds move_time(argc > 3 ? atoi(argv[3]) : 50);
+
+    cout << "depth " << depth << endl;
+    cout << setw(22) << "pruning" << setw(12) << "time ms" << setw(14) << "nodes" << endl;
+    for (const Configuration & configuration : configurations) {
+        chrono::microseconds total(0);
+        unsigned long long nodes = 0;
+        for (const char * fen : positions) {
+            ChessBoard board;
+            board.loadFEN(fen);
+            AIPlayer player(board.next_move_color, depth);
+            player.setPruning(configuration.pruning);
+
+            Move move;
+            AdvancedMoveData advanced;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            player.getMove(board, move, &advanced);
+            total += chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start);
+            nodes += advanced.nodes;
+        }
+        cout << setw(22) << configuration.name << setw(12) << fixed << setprecision(1) << total.count() / 1000.0
+             << setw(14) << nodes << endl;
+    }
+
+    if (games_per_opening <= 0)
+        return 0;
+
+    cout << endl << move_time.count() << " ms per move, against no pruning" << endl;
+    cout << setw(22) << "pruning" << setw(8) << "games" << setw(8) << "score" << setw(8) << "elo" << endl;
+    for (const Configuration & configuration : configurations) {
+        if (configuration.pruning == 0)
+            continue;
+        double score = 0;
+        int games = 0;
+        for (const char * fen : openings) {
+            for (int i = 0; i < games_per_opening; i++) {
+                // the configuration takes white in every other game
+                if (i % 2 == 0)
+                    score += playGame(fen, configuration.pruning, 0, move_time);
+                else
+                    score += 1 - playGame(fen, 0, configuration.pruning, move_time);
+                games++;
+            }
+        }
+        cout << setw(22) << configuration.name << setw(8) << games << setw(8) << setprecision(1) << score
+             << setw(8) << setprecision(0) << eloDifference(score / games) << endl;
+    }
+    return 0;
+}
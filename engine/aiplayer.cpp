@@ -3,23 +3,94 @@
 #include <list>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <thread>
 #include "aiplayer.h"
 #include "chessboard.h"
 #include "perfomancemeasurement.h"
+#include "splitsearch.h"
+#include "moveordering.h"
+#include "pawntable.h"
+#include "evalcache.h"
 
 
 using namespace std;
 
-#ifdef TRACE
-static const int QUISCENT_DEPTH = 4;
-#else
-static const int QUISCENT_DEPTH = 6;
-#endif
+// A capture is not searched in the quiescent search if even winning the
+// captured figure for nothing leaves the score this much below alpha
+static const int DELTA_MARGIN = 2 * PAWN_VALUE;
+
+static const int capture_values[7] = {
+    0, PAWN_VALUE, ROOK_VALUE, KNIGHT_VALUE, BISHOP_VALUE, QUEEN_VALUE, 0
+};
+
+// Half width of the first window around the value of the last iteration
+static const int ASPIRATION_WINDOW = PAWN_VALUE / 2;
+
+// Selective search: how deep from the horizon and by how much
+static const int REVERSE_FUTILITY_DEPTH = 3;
+static const int REVERSE_FUTILITY_MARGIN = 3 * PAWN_VALUE / 2;   // per ply
+static const int NULL_MOVE_DEPTH = 2;
+static const int NULL_MOVE_REDUCTION = 2;                       // besides the move passed
+static const int FUTILITY_DEPTH = 2;
+static const int futility_margins[FUTILITY_DEPTH + 1] = {0, 2 * PAWN_VALUE, 4 * PAWN_VALUE};
+static const int LMR_DEPTH = 3;
+static const int LMR_MOVES = 3;                                 // searched in full before reducing
+
+// Nodes nearer to the leaves are not worth the overhead of splitting
+static const int SPLIT_MIN_DEPTH = 2;
+
+// Mate scores count the plies from the root, the transposition table
+// keeps them as plies from the node stored, which is the same wherever the
+// node comes again
+static const int MATE_SCORE_PLIES = 2 * MAX_PLY;
+
+static int scoreToTable(int score, int ply)
+{
+    if (score >= WIN_VALUE - MATE_SCORE_PLIES)
+        return score + ply;
+    if (score <= -WIN_VALUE + MATE_SCORE_PLIES)
+        return score - ply;
+    return score;
+}
+
+static int scoreFromTable(int score, int ply)
+{
+    if (score >= WIN_VALUE - MATE_SCORE_PLIES)
+        return score - ply;
+    if (score <= -WIN_VALUE + MATE_SCORE_PLIES)
+        return score + ply;
+    return score;
+}
+
+/*
+* True if the result of the node will not be used: out of time or cut off
+* at a split point above
+*/
+static bool searchAborted(const EvaluationInformation * info)
+{
+    return (info->control && info->control->aborted)
+            || (info->split_point && info->split_point->cancelled());
+}
 AIPlayer::AIPlayer(int color, int search_depth)
+ : AIPlayer(color, search_depth, std::make_shared<TranspositionTable>(), std::make_shared<PawnTable>())
+{
+}
+
+AIPlayer::AIPlayer(int color, int search_depth, TTranspositionTablePtr table, TPawnTablePtr pawns)
  : ChessPlayer(color),
-   ai_depth(search_depth)
+   ai_depth(search_depth),
+   search_history(new SearchHistory()),
+   transposition_table(table),
+   pawn_table(pawns),
+   random(random_device()())
+{
+}
+
+AIPlayer::AIPlayer(int color, chrono::milliseconds move_time)
+ : AIPlayer(color, MAX_SEARCH_DEPTH)
 {
-	srand(time(NULL));
+    this->move_time = move_time;
 }
 
 AIPlayer::~AIPlayer()
@@ -29,25 +100,142 @@ void AIPlayer::prepare(const ChessBoard &board)
 {
 }
 
-bool AIPlayer::getMove(const ChessBoard & orig_board, Move & move, AdvancedMoveData *move_data)
+void AIPlayer::setHashSize(size_t megabytes)
 {
-    ChessBoard & board = const_cast<ChessBoard &>(orig_board);
-	vector<Move> candidates;
-    list<Move> regulars, simple, captures;
-    EvaluationInformation eval;
+    // other players may be searching a shared table right now, it is left
+    // to them and this player gets one of its own
+    if (transposition_table.use_count() > 1)
+        transposition_table = std::make_shared<TranspositionTable>(megabytes);
+    else
+        transposition_table->resize(megabytes);
+}
 
+void AIPlayer::setTranspositionTable(TTranspositionTablePtr table)
+{
+    transposition_table = table;
+}
 
-    int best_value, tmp;
+void AIPlayer::setPawnTable(TPawnTablePtr table)
+{
+    pawn_table = table;
+}
 
-#ifdef TRACE
-    vector<list<Move>> best_chain_candidates;
-    list<Move> chain, moved;
-    eval.moved = &moved;
-    eval.best= &chain;
-#endif
+TTranspositionTablePtr AIPlayer::getTranspositionTable() const
+{
+    return transposition_table;
+}
+
+void AIPlayer::setEvalCacheSize(size_t megabytes)
+{
+    if (megabytes == 0)
+        eval_cache.reset();
+    else if (eval_cache)
+        eval_cache->resize(megabytes);
+    else
+        eval_cache.reset(new EvalCache(megabytes));
+}
+
+void AIPlayer::setMoveTime(chrono::milliseconds time)
+{
+    move_time = time;
+}
+
+void AIPlayer::setClock(chrono::milliseconds remaining, chrono::milliseconds increment, int moves_to_go)
+{
+    clock_remaining = remaining;
+    clock_increment = increment;
+    this->moves_to_go = moves_to_go;
+}
+
+void AIPlayer::stop()
+{
+    stop_requested = true;
+}
+
+void AIPlayer::setThreads(int count)
+{
+    threads_count = max(count, 1);
+}
+
+int AIPlayer::getThreads() const
+{
+    return threads_count;
+}
+
+void AIPlayer::setParallelMode(ParallelMode mode)
+{
+    parallel_mode = mode;
+}
+
+AIPlayer::ParallelMode AIPlayer::getParallelMode() const
+{
+    return parallel_mode;
+}
+
+void AIPlayer::setPruning(int flags)
+{
+    pruning = flags;
+}
+
+int AIPlayer::getPruning() const
+{
+    return pruning;
+}
 
-    eval.depth = ai_depth - 1;
-    eval.alpha = - WIN_VALUE;
+chrono::milliseconds AIPlayer::searchTime() const
+{
+    // moves expected till the end of a sudden death game
+    static const int DEFAULT_MOVES_TO_GO = 30;
+    // kept on the clock for the overhead around the search
+    static const chrono::milliseconds CLOCK_RESERVE(50);
+
+    if (move_time.count() > 0)
+        return move_time;
+    if (clock_remaining.count() <= 0)
+        return chrono::milliseconds::zero();
+
+    int moves = moves_to_go > 0 ? moves_to_go : DEFAULT_MOVES_TO_GO;
+    chrono::milliseconds time = clock_remaining / moves + clock_increment * 3 / 4;
+    time = min(time, clock_remaining - CLOCK_RESERVE);
+    return max(time, chrono::milliseconds(1));
+}
+
+bool AIPlayer::getMove(const ChessBoard & board, Move & move, AdvancedMoveData *move_data)
+{
+    // a stop() before this search was meant for an earlier one
+    stop_requested = false;
+    return getMove(board, move, stop_requested, move_data);
+}
+
+bool AIPlayer::getMove(const ChessBoard & orig_board, Move & move, const atomic<bool> & stop,
+                       AdvancedMoveData *move_data)
+{
+    // the search moves on its own copy, the caller's board may be read by
+    // other threads meanwhile; the copy keeps the history for repetitions
+    ChessBoard board = orig_board;
+    SearchControl control;
+    SearchResult result;
+
+    chrono::milliseconds search_time = searchTime();
+    control.start = SearchControl::Clock::now();
+    control.deadline = control.start + search_time;
+    control.use_deadline = search_time.count() > 0;
+    control.stop = &stop;
+    control.interruptible = false;
+
+    transposition_table->newSearch();
+    search_history->newSearch();
+    control.history = search_history.get();
+
+    int helpers_count = 0;
+    if (threads_count > 1 && parallel_mode == YoungBrothersWait) {
+        if (NOT split_pool || split_pool->size() != threads_count)
+            split_pool.reset(new SplitSearchPool(threads_count));
+        control.pool = split_pool.get();
+        control.worker = 0;
+    } else if (threads_count > 1) {
+        helpers_count = threads_count - 1;
+    }
 
     if (board.get_all_figures_count() < 10) {
         //target_depth++;
@@ -56,17 +244,115 @@ bool AIPlayer::getMove(const ChessBoard & orig_board, Move & move, AdvancedMoveD
         //target_depth++;
     }
 
-	// first assume we are loosing
-    best_value = -KING_VALUE;
+    // helpers copy the board before this thread starts moving on it
+    atomic<bool> helpers_stop(false);
+    vector<ChessBoard> helper_boards(helpers_count, board);
+    vector<SearchControl> helper_controls(helpers_count, control);
+    vector<thread> helpers;
+    for (int i = 0; i < helpers_count; i++) {
+        helper_controls[i].stop = &helpers_stop;
+        helper_controls[i].interruptible = true;
+        helpers.emplace_back([this, &helper_boards, &helper_controls, i]() {
+            SearchResult helper_result;
+            SearchHistory history;
+            helper_controls[i].history = &history;
+            // every other helper is one iteration ahead, so the threads
+            // fill the table with different depths
+            iterativeDeepening(helper_boards[i], helper_controls[i], 1 + (i % 2 == 0), helper_result);
+        });
+    }
+
+    iterativeDeepening(board, control, 1, result);
+
+    helpers_stop = true;
+    for (thread & helper : helpers)
+        helper.join();
+
+    if (move_data) {
+        move_data->board_evaluation = result.value;
+        move_data->depth = result.depth;
+        move_data->nodes = control.nodes;
+        for (const SearchControl & helper_control : helper_controls)
+            move_data->nodes += helper_control.nodes;
+        if (control.pool)
+            move_data->nodes += control.pool->takeNodes();
+    }
+
+	// loosing the game?
+    if(result.value < -WIN_VALUE) {
+		return false;
+	}
+	else {
+		// select random move from candidate moves
+        int select = uniform_int_distribution<int>(0, result.candidates.size() - 1)(random);
+        move = result.candidates[select];
+#ifdef TRACE
+        stringstream tmp;
+        Global::instance().log("=============================================");
+        tmp << "Figures count: " << board.get_all_figures_count() << endl;
+        tmp << "Depth: "         << result.depth << endl;
+
+        tmp << "non_pawn_kick_moves_count: " << board.non_pawn_kick_moves_count << endl;
+        tmp << "Selected move (" << result.value << ")" << move.toString()
+                                << " because of next chain: ";
+        for (Move & move: result.chains[select]) {
+            tmp << move.toString() << "; ";
+        }
+        Global::instance().log(tmp.str());
+        Global::instance().log("=============================================");
+#endif
+		return true;
+    }
+}
 
-	// get all moves
-    MoveGenerator<false>::getMoves(board, board.next_move_color, simple, captures);
-    regulars.swap(captures);
-    //instead of copying
-    copy(simple.begin(), simple.end(), back_inserter(regulars));
+void AIPlayer::iterativeDeepening(ChessBoard & board, SearchControl & control,
+                                  int first_depth, SearchResult & result) const
+{
+	vector<Move> iteration_candidates;
+    MoveList regulars;
+    EvaluationInformation eval;
+    int iteration_value, tmp;
 
+#ifdef TRACE
+    vector<list<Move>> iteration_chain_candidates;
+    list<Move> chain, moved;
+    eval.moved = &moved;
+    eval.best= &chain;
+#endif
+
+    eval.ply = 1;
+    eval.control = &control;
+
+	// first assume we are loosing
+    result.value = -KING_VALUE;
+
+	// get all moves, ordered as in any other node
+    MovePicker root_picker(board, 0, control.history, 0);
+    while (Move * move = root_picker.next())
+        regulars.push_back(*move);
+
+    // iterative deepening, each iteration orders the moves for the next one
+    for (int depth = first_depth; depth <= ai_depth; depth++) {
+        eval.depth = depth - 1;
+
+        // the value of the last iteration is expected again: a narrow
+        // window around it cuts more, a value outside of it means searching
+        // again with a wider one
+        int delta = ASPIRATION_WINDOW;
+        int window_alpha = -KING_VALUE, window_beta = WIN_VALUE;
+        if (depth > first_depth && abs(result.value) < WIN_VALUE / 2) {
+            window_alpha = result.value - delta;
+            window_beta = result.value + delta;
+        }
+
+    for (;;) {
+        iteration_value = -KING_VALUE;
+        iteration_candidates.clear();
+#ifdef TRACE
+        iteration_chain_candidates.clear();
+#endif
 	// loop over all moves
-	for(list<Move>::iterator it = regulars.begin(); it != regulars.end(); ++it)
+	for(MoveList::iterator it = regulars.begin(); it != regulars.end(); ++it)
 	{
 		// execute move
         board.move(*it);
@@ -75,25 +361,29 @@ bool AIPlayer::getMove(const ChessBoard & orig_board, Move & move, AdvancedMoveD
         eval.moved->push_back(*it);
 #endif
 
-        bool current_king_vulnerable   = board.isVulnerable((board.next_move_color ? board.black_king_pos : board.white_king_pos), board.next_move_color);
-        bool previous_king_vulnerable = board.isVulnerable((board.next_move_color ? board.white_king_pos : board.black_king_pos), TOGGLE_COLOR(board.next_move_color));
-
-		// check if own king is vulnerable now
-        if(NOT previous_king_vulnerable) {
-
-            if((*it).capture != EMPTY || previous_king_vulnerable || current_king_vulnerable)
-                eval.quiescent = true;
-            else
-                eval.quiescent = false;
-
+        {
 #ifdef TRACE
             chain.clear();
             Global::instance().log(string("Try move: ") + it->toString());
 
 #endif
-            eval.beta = -best_value;
-			// recursion
-            tmp = -evalAlphaBeta(board, &eval);
+            // one below the best, so moves scoring the same are exact and
+            // not just bounds failing high in the child
+            int move_alpha = max(window_alpha, iteration_value - 1);
+
+            // after the first move a null window tells whether a move
+            // reaches the best one, only those are searched again
+            tmp = move_alpha + 1;
+            if (it != regulars.begin() && move_alpha + 1 < window_beta) {
+                eval.alpha = -(move_alpha + 1);
+                eval.beta = -move_alpha;
+                tmp = -evalAlphaBeta(board, &eval);
+            }
+            if (tmp > move_alpha && NOT control.aborted) {
+                eval.alpha = -window_beta;
+                eval.beta = -move_alpha;
+                tmp = -evalAlphaBeta(board, &eval);
+            }
 #ifdef TRACE
             stringstream sstr;
             Global::instance().log("=============================================");
@@ -109,20 +399,23 @@ bool AIPlayer::getMove(const ChessBoard & orig_board, Move & move, AdvancedMoveD
             Global::instance().log(sstr.str());
             Global::instance().log("=============================================");
 #endif
-            if(tmp > best_value) {
-                best_value = tmp;
+            if (control.aborted) {
+                // the score of an interrupted search means nothing
+            }
+            else if(tmp > iteration_value) {
+                iteration_value = tmp;
 #ifdef TRACE
-                best_chain_candidates.clear();
-                best_chain_candidates.push_back(chain);
+                iteration_chain_candidates.clear();
+                iteration_chain_candidates.push_back(chain);
 #endif
-				candidates.clear();
-				candidates.push_back(*it);
+				iteration_candidates.clear();
+				iteration_candidates.push_back(*it);
 			}
-            else if(tmp == best_value) {
-				candidates.push_back(*it);
+            else if(tmp == iteration_value) {
+				iteration_candidates.push_back(*it);
 #ifdef TRACE
 
-                best_chain_candidates.push_back(chain);
+                iteration_chain_candidates.push_back(chain);
 #endif
 			}
 		}
@@ -132,34 +425,45 @@ bool AIPlayer::getMove(const ChessBoard & orig_board, Move & move, AdvancedMoveD
 #ifdef TRACE
         eval.moved->pop_back();
 #endif
+        if (control.aborted || iteration_value >= window_beta)
+            break;
     }
-    if (move_data)
-        move_data->board_evaluation = best_value;
 
-	// loosing the game?
-    if(best_value < -WIN_VALUE) {
-		return false;
-	}
-	else {
-		// select random move from candidate moves
-        int select = rand() % candidates.size();
-        move = candidates[select];
+        if (control.aborted)
+            break;
+        // outside of the window the value is only a bound, try again wider
+        delta *= 2;
+        if (iteration_value <= window_alpha && window_alpha > -KING_VALUE)
+            window_alpha = max(window_alpha - delta, -KING_VALUE);
+        else if (iteration_value >= window_beta && window_beta < WIN_VALUE)
+            window_beta = min(window_beta + delta, WIN_VALUE);
+        else
+            break;
+    }
+
+        // out of time: keep the result of the last finished iteration
+        if (control.aborted)
+            break;
+
+        result.value = iteration_value;
+        result.candidates = iteration_candidates;
+        result.depth = depth;
 #ifdef TRACE
-        stringstream tmp;
-        Global::instance().log("=============================================");
-        tmp << "Figures count: " << board.get_all_figures_count() << endl;
-        tmp << "Depth: "         << ai_depth << endl;
+        result.chains = iteration_chain_candidates;
+#endif
+        control.interruptible = true;
 
-        tmp << "non_pawn_kick_moves_count: " << board.non_pawn_kick_moves_count << endl;
-        tmp << "Selected move (" << best_value << ")" << move.toString()
-                                << " because of next chain: ";
-        for (Move & move: best_chain_candidates[select]) {
-            tmp << move.toString() << "; ";
+        // best move of this iteration goes first in the next one
+        if (NOT result.candidates.empty()) {
+            MoveList::iterator best = find(regulars.begin(), regulars.end(), result.candidates.front());
+            rotate(regulars.begin(), best, best + 1);
         }
-        Global::instance().log(tmp.str());
-        Global::instance().log("=============================================");
-#endif
-		return true;
+
+        // the next iteration takes a few times longer than this one,
+        // do not start what cannot be finished
+        if (control.use_deadline
+                && (SearchControl::Clock::now() - control.start) * 2 > control.deadline - control.start)
+            break;
     }
 }
 
@@ -172,146 +476,151 @@ int AIPlayer::evalAlphaBeta(ChessBoard & board, const EvaluationInformation * in
 {
 #ifdef TRACE
     list<Move> chain;
-    Move best_move = EMPTY_MOVE;
 #endif
-    list<Move> regulars, simple, ignored, captures;
+    Move best_move = EMPTY_MOVE;
     int best_value, tmp, alpha = info->alpha;
 
-    bool long_depth = false, checkmate;
-    if(info->depth <= 0 && !info->quiescent) {
+    bool checkmate;
+    SearchControl * control = info->control;
+    if ((control && control->checkAbort()) || searchAborted(info))
+        return 0;
+
+    // a position repeated is a draw, whoever could avoid it has done so
+    if (board.isRepetition())
+        return 0;
+
+    // captures (and check evasions) only from here on
+    if (info->depth <= 0)
+        return quiescence(board, info);
+
+    bool in_check = board.isVulnerable(board.next_move_color ? board.black_king_pos : board.white_king_pos,
+                                       board.next_move_color);
+
+    unsigned short hash_move = 0;
+    TranspositionTable::Entry entry;
+    if (transposition_table->probe(board.hash, entry)) {
+        hash_move = entry.move;
+        int score = scoreFromTable(entry.score, info->ply);
+        if (entry.depth >= info->depth) {
+            if (entry.bound == TranspositionTable::BOUND_EXACT
+                    || (entry.bound == TranspositionTable::BOUND_LOWER && score >= info->beta)
+                    || (entry.bound == TranspositionTable::BOUND_UPPER && score <= info->alpha))
+                return score;
+        }
+    }
 
-        return +evaluateBoard(board);
-    } else if (info->quiescent && info->depth <= -QUISCENT_DEPTH) {
-        //limit maximum recursion
-        return +evaluateBoard(board);
-    } else if (info->quiescent && info->depth <= 0) {
-        long_depth = true;
+    // only a node outside the principal variation may be cut short, by
+    // how far its static value is from the window
+    bool prunable = info->beta - info->alpha == 1 && NOT in_check && abs(info->beta) < WIN_VALUE / 2;
+    int static_value = prunable ? evaluateBoard(board) : 0;
+
+    // reverse futility: far above beta near the horizon, the opponent is
+    // not going to make up for that
+    if (prunable && (pruning & ReverseFutility) && info->depth <= REVERSE_FUTILITY_DEPTH
+            && static_value - REVERSE_FUTILITY_MARGIN * info->depth >= info->beta)
+        return static_value - REVERSE_FUTILITY_MARGIN * info->depth;
+
+    // null move: if passing fails high, a real move would too. Not with the
+    // king and pawns alone, they are the ones in zugzwang.
+    int color_index = COLOR_INDEX(board.next_move_color);
+    if (prunable && (pruning & NullMove) && info->depth >= NULL_MOVE_DEPTH && NOT info->after_null_move
+            && static_value >= info->beta
+            && board.figures_count[color_index] - popCount(board.figures_bb[color_index][PAWN]) > 1) {
+        EvaluationInformation null_information;
+        null_information.depth           = info->depth - 1 - NULL_MOVE_REDUCTION - info->depth / 6;
+        null_information.ply             = info->ply + 1;
+        null_information.alpha           = - info->beta;
+        null_information.beta            = - info->beta + 1;
+        null_information.after_null_move = true;
+        null_information.control         = control;
+        null_information.split_point     = info->split_point;
+#ifdef TRACE
+        null_information.moved = info->moved;
+        null_information.best = &chain;
+#endif
+        board.makeNullMove();
+        int value = -evalAlphaBeta(board, &null_information);
+        board.undoNullMove();
+        if (value >= info->beta && NOT searchAborted(info))
+            return value >= WIN_VALUE / 2 ? info->beta : value;
     }
 
-	// first assume we are loosing
-    best_value = -WIN_VALUE + board.non_pawn_kick_moves_count; // in case we are winning lets win less moves
+    // futility: near the horizon a quiet move cannot bring the value up to alpha
+    bool futile = prunable && (pruning & Futility) && info->depth <= FUTILITY_DEPTH
+            && static_value + futility_margins[info->depth] <= alpha;
 
-    if (long_depth && !info->quiescent) {
-        // get only captures
-        MoveGenerator<true>::getMoves(board, board.next_move_color, ignored, regulars);
-    } else {
-        MoveGenerator<false>::getMoves(board, board.next_move_color, simple, captures);
-        //instead of copying
-        regulars.swap(captures);
-        copy(simple.begin(), simple.end(), back_inserter(regulars));
-    }
+	// first assume we are loosing
+    best_value = -WIN_VALUE + info->ply; // in case we are winning lets win less moves
+    int searched = 0;
 
     // assume we have a state_mate
     bool stalemate = true;
 
-    bool our_king_vulnerable_before = board.isVulnerable(board.next_move_color ? board.black_king_pos : board.white_king_pos, board.next_move_color);
-
-    if (our_king_vulnerable_before) {
+    if (in_check) {
         checkmate = true;
     } else {
         checkmate = false;
     }
 
-	// loop over all moves
-    for(list<Move>::iterator it = regulars.begin();
-        info->alpha <= info->beta && it != regulars.end(); ++it)
-    {
-		// execute move
-        board.move(*it);
+    EvaluationInformation nested_information;
+    nested_information.depth        = info->depth - 1;
+    nested_information.ply          = info->ply + 1;
+    nested_information.control      = control;
+    nested_information.split_point  = info->split_point;
 #ifdef TRACE
-        info->moved->push_back(*it);
-
-        chain.clear();
-        {
-            static int break_counter = 0;
-            stringstream trace;
-            break_counter++;
-            trace << break_counter << ": Try submove:";
-            if (break_counter == 554) {
-                cout << endl;
-            }
-            for (Move & move : *info->moved) {
-                trace << move.toString() + "->";
-            }
-            Global::instance().log(trace.str());
-
-        }
+    nested_information.moved = info->moved;
+    nested_information.best = &chain;
 #endif
-        int current_king_pos = board.next_move_color ? board.black_king_pos : board.white_king_pos;
-        int previous_king_pos = board.next_move_color ? board.white_king_pos : board.black_king_pos;
-
-        bool is_invalid_move = false;
-
-        //check if king is near the other king which is invalid
-        if (abs(current_king_pos - previous_king_pos) == 1
-                || (abs(current_king_pos - previous_king_pos) >= 7 && abs(current_king_pos - previous_king_pos) <= 9)
-                ) {
-            is_invalid_move = true;
-        }
 
-        bool current_king_vulnerable  = board.isVulnerable(current_king_pos, board.next_move_color);
-        bool previous_king_vulnerable = board.isVulnerable(previous_king_pos, TOGGLE_COLOR(board.next_move_color));
+    // the best move of an earlier search first, then captures and good quiet
+    // moves, each generated only if no move before has caused a cutoff
+    SearchHistory * history = control ? control->history : nullptr;
+    MovePicker picker(board, hash_move, history, info->ply);
+    Move * it;
 
-        //make a move and making a king vulnerable is illegal
-        if (previous_king_vulnerable) {
-            is_invalid_move = true;
-        }
+	// loop over all moves
+    while (alpha < info->beta && NOT searchAborted(info) && (it = picker.next()))
+    {
+        if (NOT searchSelectiveMove(board, *it, nested_information, info->depth, alpha, info->beta,
+                                    searched, in_check, futile, tmp))
+            continue;
+        searched++;
 
-        if (NOT is_invalid_move && NOT previous_king_vulnerable) {
-            checkmate = false;
-            stalemate = false;
-        }
+        checkmate = false;
+        stalemate = false;
 
-		// check if own king is vulnerable now
-        if(NOT is_invalid_move) {
-            bool quiescent = false;
-            if((*it).capture != EMPTY || current_king_vulnerable || previous_king_vulnerable)
-                quiescent = true;
-            else
-                quiescent = false;
-
-            EvaluationInformation nested_information;
-            nested_information.depth     = info->depth - 1;
-            nested_information.alpha     = - info->beta;
-            nested_information.beta      = - info->alpha;
-            nested_information.quiescent =  quiescent;
+        if(tmp > best_value) {
+            best_value = tmp;
+            best_move = *it;
 #ifdef TRACE
-            nested_information.moved = info->moved;
-            nested_information.best = &chain;
+            *info->best = *nested_information.best;
 #endif
-            
-            if (board.non_pawn_kick_moves_count >= 50) {
-                tmp = 0;
-            } else {
-                // recursion 'n' pruning
-                tmp = -evalAlphaBeta(board, &nested_information);
-            }
-#ifdef TRACE
-            {
-                stringstream trace;
-                for (Move & move : *info->moved) {
-                    trace << move.toString() + "->";
-                }
-                trace << tmp;
-                Global::instance().log(trace.str());
+            if(tmp > alpha) {
+                alpha = tmp;
             }
-#endif
-            if(tmp > best_value) {
-                best_value = tmp;
-#ifdef TRACE
-                best_move = *it;
-                *info->best = *nested_information.best;
-#endif
-                if(tmp > alpha) {
-                    alpha = tmp;
-				}
-			}
-		}
+        }
 
-		// undo move and inc iterator
-		board.undoMove(*it);
-#ifdef TRACE
-        info->moved->pop_back();
+#ifndef TRACE
+        // Young Brothers Wait: the eldest brother is searched, the younger
+        // ones may go to idle threads
+        if (control && control->pool && info->depth >= SPLIT_MIN_DEPTH && alpha < info->beta
+                && control->pool->hasIdleWorkers() && NOT searchAborted(info)) {
+            // all younger brothers are generated to see if there are enough
+            Move * brothers = picker.sortRemaining();
+            if (picker.end() - brothers >= 2) {
+                SplitPoint split_point(this, control, info->split_point, board, info->depth, info->ply,
+                                       alpha, info->beta, best_value, best_move, in_check, futile);
+                control->pool->split(split_point, brothers, picker.end(), searched, *control, board);
+                // a brother not searched to the end leaves this node just as
+                // incomplete as running out of time here would
+                if (split_point.aborted)
+                    control->aborted = true;
+
+                best_value = split_point.best_value;
+                best_move  = split_point.best_move;
+                break;
+            }
+        }
 #endif
     }
 
@@ -325,101 +634,259 @@ int AIPlayer::evalAlphaBeta(ChessBoard & board, const EvaluationInformation * in
         stalemate = false;
     }
     //stalemate is not so bad :)
-    return stalemate == true ? 0 : best_value;
+    if (stalemate)
+        best_value = 0;
+
+    // remember quiet moves which refute the opponent's move
+    if (history && best_value >= info->beta
+            && MovePicker::isQuiet(best_move) && NOT searchAborted(info))
+        history->addCutoff(best_move, info->ply, info->depth);
+
+    if (NOT searchAborted(info)) {
+        TranspositionTable::Bound bound = TranspositionTable::BOUND_EXACT;
+        if (best_value <= info->alpha)
+            bound = TranspositionTable::BOUND_UPPER;
+        else if (best_value >= info->beta)
+            bound = TranspositionTable::BOUND_LOWER;
+        transposition_table->store(board.hash, info->depth, bound, scoreToTable(best_value, info->ply),
+            best_move.figure ? best_move.packed() : 0);
+    }
+    return best_value;
 }
 
-int AIPlayer::evaluateBoard(const ChessBoard & board) const
-{//A7G7->G8F8->F6E6->F8G7->E6D7
-    EVALUATION_PROF_POINT;
-    int figure, pos, sum = 0, summand, row, col, edge_distance_row, edge_distance_col;
-#   ifdef TRACE
-    static int br_counter = 0;
-    br_counter ++;
-    stringstream sstr;
-    sstr << "Evalutaion Point: " << br_counter;
-    Global::instance().log(sstr.str());
-#   endif
-    int black_sum = 0, white_sum = 0;
-	for(pos = 0; pos < 64; pos++)
-	{
-		figure = board.square[pos];
-		switch(FIGURE(figure))
-		{
-			case PAWN:
-				summand = PAWN_VALUE;
-                row = pos / 8;
-                if (IS_BLACK(figure)) {
-                    summand += 6 - row;
-                } else {
-                    summand += row - 1;
-                }
-				break;
-			case ROOK:
-				summand = ROOK_VALUE;
-				break;
-			case KNIGHT:
-				summand = KNIGHT_VALUE;
-				break;
-			case BISHOP:
-				summand = BISHOP_VALUE;
-				break;
-			case QUEEN:
-				summand = QUEEN_VALUE;
-				break;
-			default:
-				summand = 0;
-				break;
-		}
-        if (IS_BLACK(figure)) {
-            black_sum +=  summand;
+int AIPlayer::quiescence(ChessBoard & board, const EvaluationInformation * info) const
+{
+    SearchControl * control = info->control;
+    if ((control && control->checkAbort()) || searchAborted(info))
+        return 0;
+    if (info->ply >= MAX_PLY)
+        return evaluateBoard(board);
+
+    bool in_check = board.isVulnerable(board.next_move_color ? board.black_king_pos : board.white_king_pos,
+                                       board.next_move_color);
+    int best_value, tmp, alpha = info->alpha;
+
+    if (in_check) {
+        // mated unless some move helps
+        best_value = -WIN_VALUE + info->ply;
+    } else {
+        // stand pat: nobody has to take, the static value is the least
+        best_value = evaluateBoard(board);
+        if (best_value >= info->beta)
+            return best_value;
+        if (best_value > alpha)
+            alpha = best_value;
+    }
+
+    EvaluationInformation nested_information;
+    nested_information.depth        = info->depth - 1;
+    nested_information.ply          = info->ply + 1;
+    nested_information.control      = control;
+    nested_information.split_point  = info->split_point;
+#ifdef TRACE
+    list<Move> chain;
+    nested_information.moved = info->moved;
+    nested_information.best = &chain;
+#endif
+
+    // in check every evasion is tried, otherwise the captures which do not
+    // lose material
+    SearchHistory * history = control ? control->history : nullptr;
+    MovePicker picker = in_check ? MovePicker(board, 0, history, info->ply) : MovePicker(board);
+    Move * it;
+
+    while (alpha < info->beta && NOT searchAborted(info) && (it = picker.next()))
+    {
+        // delta pruning, the capture cannot bring the score up to alpha
+        if (NOT in_check && it->promotion != QUEEN
+                && best_value + capture_values[FIGURE(it->capture)] + DELTA_MARGIN <= alpha)
+            continue;
+
+        nested_information.alpha = - info->beta;
+        nested_information.beta  = - alpha;
+        tmp = searchMove(board, *it, nested_information);
+
+        if (tmp > best_value) {
+            best_value = tmp;
+#ifdef TRACE
+            *info->best = *nested_information.best;
+            info->best->push_front(*it);
+#endif
+            if (tmp > alpha)
+                alpha = tmp;
+        }
+    }
+    return best_value;
+}
+
+void AIPlayer::searchSplitMove(SplitPoint & split_point, const Move & move, int searched,
+                               SearchControl & control, ChessBoard & board) const
+{
+    EvaluationInformation nested_information;
+    nested_information.depth       = split_point.depth - 1;
+    nested_information.ply         = split_point.ply + 1;
+    nested_information.control     = &control;
+    nested_information.split_point = &split_point;
+
+    // pruned and reduced as if the node were searched by one thread
+    int value;
+    if (NOT searchSelectiveMove(board, move, nested_information, split_point.depth,
+                                split_point.alpha.load(memory_order_relaxed), split_point.beta,
+                                searched, split_point.in_check, split_point.futile, value))
+        return;
+
+    // a thief runs out of time on its own counter, the owner may not have
+    // noticed yet and has to be told the brothers are incomplete
+    if (control.aborted) {
+        split_point.aborted = true;
+        return;
+    }
+    if (split_point.cancelled())
+        return;
+
+    lock_guard<mutex> lock(split_point.mutex);
+    if (value > split_point.best_value) {
+        split_point.best_value = value;
+        split_point.best_move = move;
+        if (value > split_point.alpha.load(memory_order_relaxed)) {
+            split_point.alpha.store(value, memory_order_relaxed);
+            // the other brothers are not needed any more
+            if (value >= split_point.beta)
+                split_point.cutoff = true;
+        }
+    }
+}
+
+bool AIPlayer::searchSelectiveMove(ChessBoard & board, const Move & move, EvaluationInformation & nested_information,
+                                   int depth, int alpha, int beta, int searched, bool in_check, bool futile,
+                                   int & value) const
+{
+    // quiet moves after the first may be skipped or reduced, unless they check
+    bool quiet = searched > 0 && NOT in_check && MovePicker::isQuiet(move);
+    bool late = (pruning & LateMoveReductions) && searched >= LMR_MOVES && depth >= LMR_DEPTH;
+    if (quiet && (futile || late) && board.givesCheck(move))
+        quiet = false;
+
+    if (quiet && futile)
+        return false;
+
+    int reduction = quiet && late ? 1 + (searched >= 3 * LMR_MOVES) : 0;
+    if (reduction) {
+        // a null window on the reduced depth, searched again if it fails high
+        nested_information.depth = depth - 1 - reduction;
+        nested_information.alpha = - alpha - 1;
+        nested_information.beta  = - alpha;
+        value = searchMove(board, move, nested_information);
+        nested_information.depth = depth - 1;
+    }
+    if (NOT reduction || value > alpha)
+        value = searchPvsMove(board, move, nested_information, alpha, beta, searched > 0);
+    return true;
+}
+
+int AIPlayer::searchPvsMove(ChessBoard & board, const Move & move, EvaluationInformation & nested_information,
+                            int alpha, int beta, bool scout) const
+{
+    // inside a null window already the full search is one
+    scout = scout && alpha + 1 < beta;
+    int value = 0;
+    if (scout) {
+        nested_information.alpha = - alpha - 1;
+        nested_information.beta  = - alpha;
+        value = searchMove(board, move, nested_information);
+    }
+    if (NOT scout || (value > alpha && value < beta)) {
+        nested_information.alpha = - beta;
+        nested_information.beta  = - alpha;
+        value = searchMove(board, move, nested_information);
+    }
+    return value;
+}
+
+int AIPlayer::searchMove(ChessBoard & board, const Move & move, EvaluationInformation & nested_information) const
+{
+    int value;
+		// execute move
+        board.move(move);
+#ifdef TRACE
+        nested_information.moved->push_back(move);
+
+        nested_information.best->clear();
+        {
+            stringstream trace;
+            trace << "Try submove:";
+            for (Move & move : *nested_information.moved) {
+                trace << move.toString() + "->";
+            }
+            Global::instance().log(trace.str());
+
+        }
+#endif
+        if (board.non_pawn_kick_moves_count >= 50) {
+            value = 0;
         } else {
-            white_sum +=  summand;
+            // recursion 'n' pruning
+            value = -evalAlphaBeta(board, &nested_information);
         }
-	}
-    struct {
-        int pos;
-        int opp_pos;
-        int color;
-        int figure;
-        int * value;
-    } kings[2] = {
-        {board.white_king_pos, board.black_king_pos, WHITE, board.square[board.white_king_pos], &white_sum},
-        {board.black_king_pos, board.white_king_pos, BLACK, board.square[board.black_king_pos], &black_sum}
-    };
-    for (int i = 0; i < 2; i++) {
-
-        if (kings[i].figure) {
-            if (*kings[i].value < ROOK_VALUE) {
-                // in case we have small amount of figures it is better to have a king nearer to the center
-                row = kings[i].pos / 8;
-                col = kings[i].pos % 8;
-
-                edge_distance_row = min(row, 7 - row);
-                edge_distance_col = min(col, 7 - col);
-
-                int additional_minimum = min(edge_distance_row, edge_distance_col);
-
-                *kings[i].value += additional_minimum + edge_distance_row + edge_distance_col - 6;
-
-                // lets got also a fee to be as far from the opponent king
-                int opp_row = kings[i].opp_pos / 8;
-                int opp_col = kings[i].opp_pos % 8;
-
-                int king_distance = abs(row - opp_row) + abs(col - opp_col);
-                *kings[i].value += king_distance;
+#ifdef TRACE
+        {
+            stringstream trace;
+            for (Move & move : *nested_information.moved) {
+                trace << move.toString() + "->";
             }
-            *kings[i].value += KING_VALUE;
+            trace << value;
+            Global::instance().log(trace.str());
         }
+#endif
+
+		// undo move
+		board.undoMove(move);
+#ifdef TRACE
+        nested_information.moved->pop_back();
+#endif
+    return value;
+}
+
+int AIPlayer::evaluateBoard(const ChessBoard & board) const
+{
+    EVALUATION_PROF_POINT;
+#   ifdef TRACE
+    Global::instance().log("Evalutaion Point: " + board.toFEN());
+#   endif
+    int value;
+    if (eval_cache) {
+        bool cached = eval_cache->probe(board.hash, value);
+        EVAL_CACHE_PROF_POINT(cached);
+        if (cached)
+            return value;
     }
-//    // it is
-//    sum -= board.fifty_moves;
 
-    if (IS_BLACK(this->color) )
-        sum = black_sum - white_sum;
-    else
-        sum = white_sum - black_sum;
+    // the pawn structure rarely changes, mostly it is known already
+    int pawns[2];
+    if (NOT pawn_table->probe(board.pawn_hash, pawns)) {
+        evaluatePawns(board, pawns);
+        pawn_table->store(board.pawn_hash, pawns);
+    }
+
+    // material and piece-square values come with the board, the fewer
+    // figures are left the more the endgame values count
+    int phase = min(max(board.get_all_figures_count() - 2, 0), PHASE_FIGURES);
+    int sum = ((board.psq_score[MIDGAME] + pawns[MIDGAME]) * phase
+            + (board.psq_score[ENDGAME] + pawns[ENDGAME]) * (PHASE_FIGURES - phase)) / PHASE_FIGURES;
+
+    // a lone king keeps away from the other one, which has to go after it
+    if (board.white_figures_count() == 1 || board.black_figures_count() == 1) {
+        int king_distance = abs(board.white_king_pos / 8 - board.black_king_pos / 8)
+                          + abs(board.white_king_pos % 8 - board.black_king_pos % 8);
+        if (board.white_figures_count() == 1)
+            sum += king_distance;
+        if (board.black_figures_count() == 1)
+            sum -= king_distance;
+    }
 
-	
-    return (board.next_move_color != this->color ? -sum : sum);
+    value = board.next_move_color == WHITE ? sum : -sum;
+    if (eval_cache)
+        eval_cache->store(board.hash, value);
+    return value;
 }
 
@@ -2,27 +2,82 @@
 #define AI_PLAYER_H_INCLUDED
 
 #include "chessplayer.h"
+#include "evaluation.h"
+#include "transpositiontable.h"
 #include <global.h>
+#include <atomic>
+#include <chrono>
 #include <list>
+#include <random>
+#include <vector>
 
-
-// Pieces' values
-#define WIN_VALUE  50000	// win the game
-#define PAWN_VALUE    30	// 8x
-#define ROOK_VALUE    90	// 2x
-#define KNIGHT_VALUE  85	// 2x
-#define BISHOP_VALUE  84	// 2x
-#define QUEEN_VALUE  300	// 1x
-#define KING_VALUE 	 ((PAWN_VALUE * 8) + (ROOK_VALUE * 2) \
-						+ (KNIGHT_VALUE * 2) + (BISHOP_VALUE * 2) + QUEEN_VALUE + WIN_VALUE)
+// Depth limit of searches bounded by time only
+#define MAX_SEARCH_DEPTH 64
 
 class ChessBoard;
+class SplitSearchPool;
+class PawnTable;
+typedef std::shared_ptr<PawnTable> TPawnTablePtr;
+class EvalCache;
+struct SplitPoint;
+struct SearchHistory;
+
+/*
+* State of one running search shared by all of its nodes: node counter,
+* deadline and the flag to stop it from outside
+*/
+struct SearchControl {
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::time_point start;
+    Clock::time_point deadline;
+    bool use_deadline = false;
+    const std::atomic<bool> * stop = nullptr;
+    // cleared while searching the first iteration, which has to finish
+    bool interruptible = true;
+    unsigned long long nodes = 0;
+    bool aborted = false;
+
+    // split point search: the pool and the index of this thread in it
+    SplitSearchPool * pool = nullptr;
+    int worker = 0;
+
+    // move ordering statistics of this thread
+    SearchHistory * history = nullptr;
+
+    /*
+    * Counts the node, looks at the clock and the stop flag every
+    * 1024 nodes. Once aborted all results of the search are garbage.
+    */
+    bool checkAbort() {
+        if (((++nodes & 1023) == 0) && interruptible && NOT aborted) {
+            aborted = (stop && stop->load(std::memory_order_relaxed))
+                    || (use_deadline && Clock::now() >= deadline);
+        }
+        return aborted;
+    }
+};
+
+/*
+* Outcome of the root search of one thread
+*/
+struct SearchResult {
+    int value = 0;
+    int depth = 0;                  // last finished iteration
+    std::vector<Move> candidates;   // moves scoring value
+    #ifdef TRACE
+    std::vector<std::list<Move>> chains;
+    #endif
+};
 
 struct EvaluationInformation {
     int depth = 0;
+    int ply = 0;    // distance from the root
     int alpha = 0;
     int beta = 0;
-    bool quiescent = 0;
+    bool after_null_move = false;   // no second one in a row
+    SearchControl * control = nullptr;
+    const SplitPoint * split_point = nullptr; // innermost one above the node
     #ifdef TRACE
     std::list<Move> * moved = NULL;
     std::list<Move> * best = NULL;
@@ -32,13 +87,49 @@ struct EvaluationInformation {
 class AIPlayer: public ChessPlayer {
 
 	public:
+
+        enum ParallelMode {
+            LazySmp,            // helpers search the whole tree, sharing the table
+            YoungBrothersWait   // threads split the moves of a node after the first
+        };
+
+        /*
+        * Selective search, each technique may be switched off on its own
+        */
+        enum Pruning {
+            NullMove            = 1,    // let the opponent move twice, a cutoff anyway ends the node
+            LateMoveReductions  = 2,    // quiet moves ordered late are searched less deep first
+            Futility            = 4,    // quiet moves near the horizon which cannot reach alpha
+            ReverseFutility     = 8,    // nodes near the horizon far above beta
+            AllPruning          = NullMove | LateMoveReductions | Futility | ReverseFutility
+        };
 	
         AIPlayer(int color, int search_depth);
 
+        /*
+        * Searches as deep as the time for one move allows
+        */
+        AIPlayer(int color, std::chrono::milliseconds move_time);
+
+        /*
+        * Searches with the given tables. The pawn table may be shared with
+        * players of other games, the transposition table only within one
+        * game: its scores depend on the moves played before.
+        */
+        AIPlayer(int color, int search_depth, TTranspositionTablePtr table, TPawnTablePtr pawns);
+
 		~AIPlayer();
 
         void prepare(const ChessBoard & board) override;
         bool getMove(const ChessBoard & board, Move & move, AdvancedMoveData * move_data = nullptr) override;
+
+        /*
+        * Search stopped by the caller's flag instead of stop(), set before
+        * or during the search. The flag belongs to this one search, so its
+        * owner cannot stop any other.
+        */
+        bool getMove(const ChessBoard & board, Move & move, const std::atomic<bool> & stop,
+                     AdvancedMoveData * move_data = nullptr);
         void showMove(const ChessBoard & board, Move & move) override;
 
 		/*
@@ -46,10 +137,109 @@ class AIPlayer: public ChessPlayer {
 		*/ 
         int evalAlphaBeta(ChessBoard & board, const EvaluationInformation * info) const;
 
+        /*
+        * Search below the horizon: the side to move may stand pat on the
+        * static value or try captures, only in check all moves are
+        * searched. Ends when the position is quiet.
+        */
+        int quiescence(ChessBoard & board, const EvaluationInformation * info) const;
+
+        /*
+        * Executes the move, searches the position after it and takes the
+        * move back. The window and depth come with nested_information.
+        * Returns the value of the move for the side making it.
+        */
+        int searchMove(ChessBoard & board, const Move & move, EvaluationInformation & nested_information) const;
+
+        /*
+        * Principal variation search of a move in the window (alpha, beta).
+        * With scout set the move is expected to be worse than alpha (it is
+        * not the first one), a null window proves that and only a move
+        * which fails high is searched again with the whole window.
+        */
+        int searchPvsMove(ChessBoard & board, const Move & move, EvaluationInformation & nested_information,
+                          int alpha, int beta, bool scout) const;
+
+        /*
+        * Searches the move as the searched-th one of a node of the given
+        * depth and window: after the first, a quiet move is skipped if the
+        * node is futile and searched less deep first if it comes late.
+        * Returns false if the move was skipped.
+        */
+        bool searchSelectiveMove(ChessBoard & board, const Move & move, EvaluationInformation & nested_information,
+                                 int depth, int alpha, int beta, int searched, bool in_check, bool futile,
+                                 int & value) const;
+
 		/*
-		* For now, this checks only material
+		* Score for the side to move: material, piece-square values and pawn
+		* structure, tapered between middlegame and endgame by the figures left
 		*/
 		int evaluateBoard(const ChessBoard & board) const;
+
+        /*
+        * Transposition table size, the table keeps its entries between moves.
+        * A table shared with other players is not resized, this player gets
+        * a new one instead. Not while this player is searching.
+        */
+        void setHashSize(size_t megabytes);
+
+        /*
+        * Lets several players (or search threads) of one game share a table
+        */
+        void setTranspositionTable(TTranspositionTablePtr table);
+        TTranspositionTablePtr getTranspositionTable() const;
+        void setPawnTable(TPawnTablePtr table);
+
+        /*
+        * Size of the cache of static evaluations, 0 (the default) for none.
+        * The evaluation is mostly incremental, so the cache only helps where
+        * memory is fast compared to it; measure_eval_cache tells how often
+        * it hits in PROFILE builds.
+        */
+        void setEvalCacheSize(size_t megabytes);
+
+        /*
+        * Fixed time for every move, zero for no limit. The search deepens
+        * iteratively up to the search depth and plays the best move of the
+        * last finished iteration when the time runs out.
+        */
+        void setMoveTime(std::chrono::milliseconds time);
+
+        /*
+        * Time left on the clock before the next getMove(). The time for the
+        * move is taken from it, moves_to_go 0 means a sudden death game.
+        * Ignored when a move time is set.
+        */
+        void setClock(std::chrono::milliseconds remaining, std::chrono::milliseconds increment,
+                      int moves_to_go = 0);
+
+        /*
+        * Makes a running getMove() return the best move found so far.
+        * May be called from any thread.
+        */
+        void stop();
+
+        /*
+        * Lazy SMP: besides the calling thread count - 1 helpers search the
+        * same root on their own board copies. They share nothing but the
+        * transposition table, the move comes from the calling thread.
+        */
+        void setThreads(int count);
+        int getThreads() const;
+
+        /*
+        * How the threads set by setThreads() share the work. With split
+        * points the threads are kept between moves.
+        */
+        void setParallelMode(ParallelMode mode);
+        ParallelMode getParallelMode() const;
+
+        /*
+        * Pruning techniques used, a combination of Pruning flags. All of
+        * them by default.
+        */
+        void setPruning(int flags);
+        int getPruning() const;
 	
 	protected:
 
@@ -57,6 +247,47 @@ class AIPlayer: public ChessPlayer {
 		* how deep to min-max
 		*/
         int ai_depth;
+
+        /*
+        * Time for the next move, zero for no limit
+        */
+        std::chrono::milliseconds searchTime() const;
+
+        /*
+        * Searches the root moves with growing depth, starting at first_depth,
+        * till the search depth or till the control aborts
+        */
+        void iterativeDeepening(ChessBoard & board, SearchControl & control,
+                                int first_depth, SearchResult & result) const;
+
+        /*
+        * Searches one move of a split point, the searched-th of its node,
+        * and merges the result into it
+        */
+        void searchSplitMove(SplitPoint & split_point, const Move & move, int searched,
+                             SearchControl & control, ChessBoard & board) const;
+        friend class SplitSearchPool;
+
+        int threads_count = 1;
+        ParallelMode parallel_mode = LazySmp;
+        int pruning = AllPruning;
+        std::unique_ptr<SplitSearchPool> split_pool;
+        std::unique_ptr<SearchHistory> search_history;
+
+        std::chrono::milliseconds move_time{0};
+        std::chrono::milliseconds clock_remaining{0};
+        std::chrono::milliseconds clock_increment{0};
+        int moves_to_go = 0;
+
+        std::atomic<bool> stop_requested{false};
+
+        TTranspositionTablePtr transposition_table;
+        TPawnTablePtr pawn_table;
+        std::unique_ptr<EvalCache> eval_cache;
+
+        // picks one of the equally good moves, per player so that players
+        // in different threads do not share it
+        std::mt19937 random;
 };
 
 #endif
@@ -0,0 +1,89 @@
+#include "asyncaiplayer.h"
+#include "chessboard.h"
+
+using namespace std;
+
+AsyncAiPlayer::AsyncAiPlayer(int color, int search_depth, TComputePoolPtr pool)
+ : AsyncPlayer(color),
+   player(color, search_depth, pool->newTranspositionTable(), pool->getPawnTable()),
+   pool(pool)
+{
+}
+
+void AsyncAiPlayer::asyncPrepare(const ChessBoard & board, ReadyHandler handler)
+{
+    player.prepare(board);
+    complete(generation, handler);
+}
+
+void AsyncAiPlayer::asyncGetNext(const ChessBoard & board, MoveReadyHandler handler)
+{
+    shared_ptr<AsyncAiPlayer> self = shared_from_this();
+    unsigned operation = generation;
+    auto stop = make_shared<atomic<bool>>(false);
+    {
+        lock_guard<std::mutex> lock(mutex);
+        search_stop = stop;
+    }
+    // the caller goes on with its board, the search needs its own
+    pool->post([self, board, handler, operation, stop]() {
+        if (*stop)
+            return;
+        Move move = EMPTY_MOVE;
+        AdvancedMoveData move_data;
+        self->player.setColor(self->color);
+        if (NOT self->player.getMove(board, move, *stop, &move_data))
+            move = EMPTY_MOVE;
+        {
+            lock_guard<std::mutex> lock(self->mutex);
+            self->last_move_data = move_data;
+        }
+        self->complete(operation, [handler, move]() {
+            handler(move);
+        });
+    });
+}
+
+void AsyncAiPlayer::asyncShowMove(const ChessBoard &, const Move &, ReadyHandler handler)
+{
+    complete(generation, handler);
+}
+
+void AsyncAiPlayer::asyncShowResult(const ChessBoard &, EndStatus, ReadyHandler handler)
+{
+    complete(generation, handler);
+}
+
+void AsyncAiPlayer::cancel()
+{
+    lock_guard<std::mutex> lock(mutex);
+    generation++;
+    if (search_stop)
+        *search_stop = true;
+}
+
+AIPlayer & AsyncAiPlayer::getAiPlayer()
+{
+    return player;
+}
+
+AdvancedMoveData AsyncAiPlayer::getLastMoveData() const
+{
+    lock_guard<std::mutex> lock(mutex);
+    return last_move_data;
+}
+
+void AsyncAiPlayer::complete(unsigned operation, function<void()> handler)
+{
+    if (NOT strand) {
+        if (operation == generation)
+            handler();
+        return;
+    }
+    // checked on the strand, where the owner of the player cancels it
+    shared_ptr<AsyncAiPlayer> self = shared_from_this();
+    strand->post([self, operation, handler]() {
+        if (operation == self->generation)
+            handler();
+    });
+}
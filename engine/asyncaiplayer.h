@@ -0,0 +1,62 @@
+#pragma once
+#include "asyncplayer.h"
+#include "aiplayer.h"
+#include "computepool.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+/*
+* AIPlayer behind the asynchronous interface: the search runs on a compute
+* pool, the handlers are called on the strand of the player (right on the
+* pool thread if it has none). Hold it by shared_ptr, a running search
+* keeps it alive.
+*
+* A player which gives up answers EMPTY_MOVE.
+*/
+class AsyncAiPlayer: public AsyncPlayer, public std::enable_shared_from_this<AsyncAiPlayer>
+{
+public:
+    AsyncAiPlayer(int color, int search_depth, TComputePoolPtr pool = ComputePool::shared());
+
+    void asyncPrepare(const ChessBoard & board, ReadyHandler handler) override;
+    void asyncGetNext(const ChessBoard & board, MoveReadyHandler handler) override;
+    void asyncShowMove(const ChessBoard & board, const Move & move, ReadyHandler handler) override;
+    void asyncShowResult(const ChessBoard & board, EndStatus status, ReadyHandler handler) override;
+
+    /*
+    * Stops the search asked for last, queued or running; handlers of
+    * operations started before are not called any more. Searches asked
+    * for later are not affected. May be called from any thread.
+    */
+    void cancel() override;
+
+    /*
+    * The search settings, not to be changed while searching
+    */
+    AIPlayer & getAiPlayer();
+
+    /*
+    * Depth, nodes and value of the last finished search
+    */
+    AdvancedMoveData getLastMoveData() const;
+
+private:
+    /*
+    * Calls the handler on the strand unless the player was cancelled
+    * after the operation started
+    */
+    void complete(unsigned operation, std::function<void()> handler);
+
+    AIPlayer player;
+    TComputePoolPtr pool;
+    // bumped by cancel()
+    std::atomic<unsigned> generation{0};
+
+    mutable std::mutex mutex;
+    // stop flag of the search asked for last, each search has its own
+    std::shared_ptr<std::atomic<bool>> search_stop;
+    AdvancedMoveData last_move_data;
+};
+typedef std::shared_ptr<AsyncAiPlayer> TAsyncAiPlayerPtr;
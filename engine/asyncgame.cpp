@@ -0,0 +1,165 @@
+#include "asyncgame.h"
+
+using namespace std;
+
+GameMetrics::GameMetrics()
+ : start(Clock::now())
+{
+}
+
+double GameMetrics::gamesPerSecond() const
+{
+    double seconds = chrono::duration<double>(Clock::now() - start).count();
+    return seconds > 0 ? games_finished / seconds : 0.0;
+}
+
+double GameMetrics::movesPerSecond() const
+{
+    double seconds = chrono::duration<double>(Clock::now() - start).count();
+    return seconds > 0 ? moves / seconds : 0.0;
+}
+
+AsyncGame::AsyncGame(shared_ptr<boost::asio::io_service> io, TAsyncPlayerPtr white, TAsyncPlayerPtr black)
+ : io(io),
+   strand(make_shared<boost::asio::io_service::strand>(*io)),
+   players{white, black}
+{
+    board.initDefaultSetup();
+    white->setColor(WHITE);
+    black->setColor(BLACK);
+    white->setStrand(strand);
+    black->setStrand(strand);
+}
+
+void AsyncGame::loadFEN(const string & fen)
+{
+    board.loadFEN(fen);
+}
+
+void AsyncGame::setMaxPlies(int plies)
+{
+    max_plies = plies;
+}
+
+void AsyncGame::setMetrics(TGameMetricsPtr metrics)
+{
+    this->metrics = metrics;
+}
+
+const ChessBoard & AsyncGame::getBoard() const
+{
+    return board;
+}
+
+int AsyncGame::getPlies() const
+{
+    return plies;
+}
+
+AsyncPlayer::ReadyHandler AsyncGame::onStrand(AsyncPlayer::ReadyHandler handler)
+{
+    shared_ptr<boost::asio::io_service::strand> game_strand = strand;
+    // a player keeping to the strand is already on it, dispatch calls at once
+    return [game_strand, handler]() {
+        game_strand->dispatch(handler);
+    };
+}
+
+void AsyncGame::start(AsyncPlayer::ResultReadyHandler handler)
+{
+    result_handler = handler;
+    work.reset(new boost::asio::io_service::work(*io));
+    if (metrics)
+        metrics->games_started++;
+    strand->post([this]() {
+        players[0]->asyncPrepare(board, onStrand([this]() {
+            players[1]->asyncPrepare(board, onStrand([this]() {
+                requestMove();
+            }));
+        }));
+    });
+}
+
+void AsyncGame::cancel()
+{
+    strand->dispatch([this]() {
+        if (finished)
+            return;
+        players[0]->cancel();
+        players[1]->cancel();
+        finish(AsyncPlayer::NONE);
+    });
+}
+
+void AsyncGame::requestMove()
+{
+    if (finished)
+        return;
+
+    switch (board.getPlayerStatus(board.next_move_color)) {
+        case ChessPlayer::Checkmate:
+            finish(board.next_move_color == WHITE ? AsyncPlayer::WHITE_LOOSE : AsyncPlayer::WHITE_WIN);
+            return;
+        case ChessPlayer::Stalemate:
+        case ChessPlayer::Draw:
+            finish(AsyncPlayer::DRAW);
+            return;
+        default:
+            break;
+    }
+    if (max_plies > 0 && plies >= max_plies) {
+        finish(AsyncPlayer::DRAW);
+        return;
+    }
+
+    move_requested = GameMetrics::Clock::now();
+    shared_ptr<boost::asio::io_service::strand> game_strand = strand;
+    players[COLOR_INDEX(board.next_move_color)]->asyncGetNext(board, [this, game_strand](const Move & move) {
+        game_strand->dispatch([this, move]() {
+            onMove(move);
+        });
+    });
+}
+
+void AsyncGame::onMove(const Move & move)
+{
+    if (finished)
+        return;
+    if (metrics) {
+        metrics->move_latency.AddMeasure(
+            chrono::duration_cast<chrono::microseconds>(GameMetrics::Clock::now() - move_requested));
+    }
+
+    Move checked = move;
+    bool gives_up = move.from == move.to;
+    if (gives_up || NOT board.isValidMove(board.next_move_color, checked)) {
+        finish(board.next_move_color == WHITE ? AsyncPlayer::WHITE_LOOSE : AsyncPlayer::WHITE_WIN);
+        return;
+    }
+
+    board.move(checked);
+    plies++;
+    if (metrics)
+        metrics->moves++;
+    players[COLOR_INDEX(board.next_move_color)]->asyncShowMove(board, checked, onStrand([this]() {
+        requestMove();
+    }));
+}
+
+void AsyncGame::finish(AsyncPlayer::EndStatus status)
+{
+    finished = true;
+    end_status = status;
+    if (metrics)
+        metrics->games_finished++;
+    players[0]->asyncShowResult(board, status, onStrand([this]() {
+        players[1]->asyncShowResult(board, end_status, onStrand([this]() {
+            // the game may be gone once the handler returns
+            AsyncPlayer::ResultReadyHandler handler;
+            swap(handler, result_handler);
+            work.reset();
+            if (handler)
+                handler(end_status);
+        }));
+    }));
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include "asyncplayer.h"
+#include "chessboard.h"
+#include "perfomancemeasurement.h"
+
+#include <boost/asio/io_service.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+/*
+* Counters of any number of games, updated from all their threads
+*/
+struct GameMetrics
+{
+    typedef std::chrono::steady_clock Clock;
+
+    GameMetrics();
+    GameMetrics(const GameMetrics &) = delete;
+    GameMetrics& operator = (const GameMetrics &) = delete;
+
+    double gamesPerSecond() const;
+    double movesPerSecond() const;
+
+    Clock::time_point start;
+    std::atomic<long long> games_started{0};
+    std::atomic<long long> games_finished{0};
+    std::atomic<long long> moves{0};
+    // from asking a player for a move till it is made on the board,
+    // waiting for a compute thread included
+    LatencyMeasurement move_latency;
+};
+typedef std::shared_ptr<GameMetrics> TGameMetricsPtr;
+
+/*
+* One game between two asynchronous players. All of its steps run on a
+* strand of the io_service, so a game needs no locks and any number of
+* games share the io threads. The players get the strand, their colors
+* and the board; a move is asked for only after the opponent has been
+* shown the last one.
+*
+* The game has to outlive its result handler, which is called last.
+*/
+class AsyncGame
+{
+public:
+    AsyncGame(std::shared_ptr<boost::asio::io_service> io, TAsyncPlayerPtr white, TAsyncPlayerPtr black);
+    AsyncGame(const AsyncGame &) = delete;
+    AsyncGame& operator = (const AsyncGame &) = delete;
+
+    /*
+    * Position to start from instead of the initial one, before start()
+    */
+    void loadFEN(const std::string & fen);
+
+    /*
+    * Games longer than that are drawn, 0 (the default) for no limit
+    */
+    void setMaxPlies(int plies);
+
+    void setMetrics(TGameMetricsPtr metrics);
+
+    /*
+    * Starts the game, the handler gets its result. A player making an
+    * invalid move or giving up (EMPTY_MOVE) loses.
+    */
+    void start(AsyncPlayer::ResultReadyHandler handler);
+
+    /*
+    * Ends the game with the result NONE, cancelling the players
+    */
+    void cancel();
+
+    /*
+    * The position reached, to be looked at once the game has ended
+    */
+    const ChessBoard & getBoard() const;
+    int getPlies() const;
+
+private:
+    void requestMove();
+    void onMove(const Move & move);
+    void finish(AsyncPlayer::EndStatus status);
+
+    /*
+    * Runs the handler of a player on the strand of the game
+    */
+    AsyncPlayer::ReadyHandler onStrand(AsyncPlayer::ReadyHandler handler);
+
+    std::shared_ptr<boost::asio::io_service> io;
+    std::shared_ptr<boost::asio::io_service::strand> strand;
+    TAsyncPlayerPtr players[2]; // [color index]
+    ChessBoard board;
+    int plies = 0;
+    int max_plies = 0;
+    bool finished = false;
+    AsyncPlayer::EndStatus end_status = AsyncPlayer::NONE;
+    AsyncPlayer::ResultReadyHandler result_handler;
+    // keeps the io threads running while the players think
+    std::unique_ptr<boost::asio::io_service::work> work;
+    TGameMetricsPtr metrics;
+    GameMetrics::Clock::time_point move_requested;
+};
@@ -2,6 +2,7 @@
 #include "chessplayer.h"
 
 #include <boost/asio/io_service.hpp>
+#include <boost/asio/strand.hpp>
 #include <functional>
 
 class AsyncPlayer /*: public ChessPlayer*/
@@ -0,0 +1,164 @@
+#include "bitboard.h"
+#include <cassert>
+
+TBitBoard knight_attacks[64];
+TBitBoard king_attacks[64];
+TBitBoard pawn_attacks[2][64];
+TBitBoard between_bb[64][64];
+TBitBoard line_bb[64][64];
+
+Magic rook_magics[64];
+Magic bishop_magics[64];
+
+// Attack sets for every relevant occupancy of every square
+static TBitBoard rook_table[0x19000];
+static TBitBoard bishop_table[0x1480];
+
+// Magic factors, found offline by a trial-and-error search over sparse
+// random numbers with the minimal index width for every square
+static const TBitBoard rook_magic_numbers[64] = {
+    0x010011c080022100ULL, 0x4c40002000100040ULL, 0x48801882a000d001ULL, 0x8480080080100005ULL,
+    0x0200020010040920ULL, 0x1080010400020080ULL, 0x0880410002000080ULL, 0x020000420429008cULL,
+    0x3000801080204004ULL, 0x0200802000400088ULL, 0x6102001081264200ULL, 0x000200100e002040ULL,
+    0x0804800801040280ULL, 0x00430004000a1900ULL, 0xf001010002000401ULL, 0x1020800080104100ULL,
+    0x0080004000200043ULL, 0x2000444008201001ULL, 0x0882020010402880ULL, 0x4088008080081000ULL,
+    0x0006808004000800ULL, 0x028d010004000208ULL, 0x2068040008420110ULL, 0x00a102000264008dULL,
+    0x4120400080002080ULL, 0x0002010200204080ULL, 0xc004200100184101ULL, 0x1240100100090020ULL,
+    0x0240040080800800ULL, 0x0818040080800200ULL, 0x0c20280400210210ULL, 0x0002a04200088114ULL,
+    0x4000804000800020ULL, 0x0030004000402000ULL, 0x0890040800202000ULL, 0x0040200a02001041ULL,
+    0x64c6002012000804ULL, 0x0020800200800400ULL, 0x8a0e008102000804ULL, 0x040000a402000041ULL,
+    0x2000800040008028ULL, 0x0040200050004000ULL, 0x0220100020008080ULL, 0x10c100201001000cULL,
+    0x0000040008008080ULL, 0x0042001028e20004ULL, 0x1005010802040010ULL, 0x018004004c820025ULL,
+    0x0002410880082d00ULL, 0x0000802000400180ULL, 0x2302822000100480ULL, 0x9e00801000080080ULL,
+    0x0200080080040080ULL, 0x9103000400020900ULL, 0x80103001c2080400ULL, 0x0402140490510200ULL,
+    0x0110402200108106ULL, 0x0002142080400901ULL, 0x8007002ac0200053ULL, 0x0000050020100109ULL,
+    0x0421001004080043ULL, 0x00a5000882040001ULL, 0x0182020090010804ULL, 0x2040009401084022ULL
+};
+
+static const TBitBoard bishop_magic_numbers[64] = {
+    0x00401000a0808080ULL, 0x4042100101050080ULL, 0x0a04112403008000ULL, 0x01080481101804c2ULL,
+    0x0001114010000020ULL, 0x0032080404185002ULL, 0x0006082403181000ULL, 0x0021040042380441ULL,
+    0x8288a08204410410ULL, 0x4100090801040020ULL, 0x0101214104088020ULL, 0x000002208200804eULL,
+    0xb400011040800206ULL, 0x14140486a0202020ULL, 0x50288400a2082000ULL, 0x0030460200b21860ULL,
+    0xc9228010a0011f0aULL, 0x0060009102220048ULL, 0x0050000121002100ULL, 0x404800a082084208ULL,
+    0x8000882c00a00801ULL, 0x0201000890080100ULL, 0x9002003c01010840ULL, 0x0002080040442400ULL,
+    0x0028200040220210ULL, 0x0152208010110200ULL, 0x4008040402040018ULL, 0x6482018038005840ULL,
+    0x0000840028802010ULL, 0x001b020160405008ULL, 0x0001140480420800ULL, 0x2044124001290401ULL,
+    0x80ca82c000501002ULL, 0x0002080200243080ULL, 0x8800248800100822ULL, 0x0088020080280080ULL,
+    0x00a0440400104100ULL, 0x2002009a00010801ULL, 0x8004012040040420ULL, 0x0802020208002090ULL,
+    0x8026113040082810ULL, 0x3004040168060450ULL, 0x0080820801024200ULL, 0x5000232018010100ULL,
+    0x0120093024000880ULL, 0x0402200050824100ULL, 0x0008100080880200ULL, 0x0008090046000280ULL,
+    0x0040410420200080ULL, 0x8008450098200020ULL, 0x0200123308080008ULL, 0x0120200042020044ULL,
+    0x0200001002022000ULL, 0x0040042184010200ULL, 0x2138091004254222ULL, 0x8411100100508104ULL,
+    0x0201010050040400ULL, 0x2800015242101010ULL, 0x2518088022015020ULL, 0x0000050008840400ULL,
+    0x1208480011121203ULL, 0x0400042020310240ULL, 0x440d204204016400ULL, 0x2008010404040021ULL
+};
+
+static const int rook_steps[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+static const int bishop_steps[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+
+static TBitBoard stepAttacks(int pos, const int (*steps)[2], int count)
+{
+    TBitBoard result = 0;
+    int row = pos / 8, col = pos % 8;
+
+    for (int i = 0; i < count; i++) {
+        int target_row = row + steps[i][0];
+        int target_col = col + steps[i][1];
+        if (target_row >= 0 && target_row < 8 && target_col >= 0 && target_col < 8)
+            result |= BIT(target_row * 8 + target_col);
+    }
+    return result;
+}
+
+/*
+* Walks the four rays square by square. Only used to fill the tables.
+*/
+static TBitBoard slidingAttacks(int pos, TBitBoard occupied, const int (*steps)[2])
+{
+    TBitBoard result = 0;
+
+    for (int i = 0; i < 4; i++) {
+        int row = pos / 8 + steps[i][0];
+        int col = pos % 8 + steps[i][1];
+        for (; row >= 0 && row < 8 && col >= 0 && col < 8; row += steps[i][0], col += steps[i][1]) {
+            result |= BIT(row * 8 + col);
+            if (occupied & BIT(row * 8 + col))
+                break;
+        }
+    }
+    return result;
+}
+
+static void initMagics(Magic * magics, const TBitBoard * magic_numbers,
+    TBitBoard * table, const int (*steps)[2])
+{
+    for (int pos = 0; pos < 64; pos++) {
+        Magic & m = magics[pos];
+
+        // the board edges never block a ray, so they are not part of the key
+        TBitBoard edges = ((RANK_1_BB | RANK_8_BB) & ~(RANK_1_BB << (pos / 8 * 8)))
+                        | ((FILE_A_BB | FILE_H_BB) & ~(FILE_A_BB << (pos % 8)));
+        m.mask = slidingAttacks(pos, 0, steps) & ~edges;
+        m.magic = magic_numbers[pos];
+        m.shift = 64 - popCount(m.mask);
+        m.attacks = table;
+
+        // enumerate all subsets of the mask (Carry-Rippler)
+        TBitBoard occupied = 0;
+        do {
+            TBitBoard & entry = m.attacks[m.index(occupied)];
+            TBitBoard attacks = slidingAttacks(pos, occupied, steps);
+            assert(entry == 0 || entry == attacks);
+            entry = attacks;
+            occupied = (occupied - m.mask) & m.mask;
+        } while (occupied);
+
+        table += BIT(popCount(m.mask));
+    }
+}
+
+static void initAttackTables()
+{
+    static const int knight_steps[8][2] = {
+        {2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2}
+    };
+    static const int king_steps[8][2] = {
+        {1, 1}, {1, 0}, {1, -1}, {0, 1}, {0, -1}, {-1, 1}, {-1, 0}, {-1, -1}
+    };
+    static const int white_pawn_steps[2][2] = {{1, 1}, {1, -1}};
+    static const int black_pawn_steps[2][2] = {{-1, 1}, {-1, -1}};
+
+    for (int pos = 0; pos < 64; pos++) {
+        knight_attacks[pos] = stepAttacks(pos, knight_steps, 8);
+        king_attacks[pos] = stepAttacks(pos, king_steps, 8);
+        pawn_attacks[0][pos] = stepAttacks(pos, white_pawn_steps, 2);
+        pawn_attacks[1][pos] = stepAttacks(pos, black_pawn_steps, 2);
+    }
+
+    initMagics(rook_magics, rook_magic_numbers, rook_table, rook_steps);
+    initMagics(bishop_magics, bishop_magic_numbers, bishop_table, bishop_steps);
+
+    // two aligned squares see each other on an empty board, the squares
+    // between them are those both see with only the two of them occupied
+    for (int from = 0; from < 64; from++) {
+        for (int to = 0; to < 64; to++) {
+            if (from == to)
+                continue;
+            const TBitBoard ends = BIT(from) | BIT(to);
+            if (rookAttacks(from, 0) & BIT(to)) {
+                line_bb[from][to] = (rookAttacks(from, 0) & rookAttacks(to, 0)) | ends;
+                between_bb[from][to] = rookAttacks(from, ends) & rookAttacks(to, ends);
+            } else if (bishopAttacks(from, 0) & BIT(to)) {
+                line_bb[from][to] = (bishopAttacks(from, 0) & bishopAttacks(to, 0)) | ends;
+                between_bb[from][to] = bishopAttacks(from, ends) & bishopAttacks(to, ends);
+            }
+        }
+    }
+}
+
+// Tables are filled before main() and only read afterwards, so all search
+// threads may share them without any synchronisation
+static struct AttackTablesInitializer {
+    AttackTablesInitializer() { initAttackTables(); }
+} attack_tables_initializer;
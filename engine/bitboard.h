@@ -0,0 +1,105 @@
+#pragma once
+#include <cstdint>
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+/*
+* One bit per square, bit 0 is A1 and bit 63 is H8 (same layout as
+* ChessBoard::square).
+*/
+typedef uint64_t TBitBoard;
+
+#define BIT(pos) (static_cast<TBitBoard>(1) << (pos))
+
+#define FILE_A_BB 0x0101010101010101ULL
+#define FILE_H_BB 0x8080808080808080ULL
+#define RANK_1_BB 0x00000000000000FFULL
+#define RANK_8_BB 0xFF00000000000000ULL
+
+inline int popCount(TBitBoard bb)
+{
+    return __builtin_popcountll(bb);
+}
+
+/*
+* Index of the least significant set bit. bb must not be empty.
+*/
+inline int bitScanForward(TBitBoard bb)
+{
+    return __builtin_ctzll(bb);
+}
+
+/*
+* Index of the most significant set bit. bb must not be empty.
+*/
+inline int bitScanReverse(TBitBoard bb)
+{
+    return 63 - __builtin_clzll(bb);
+}
+
+/*
+* Removes the least significant set bit and returns its index.
+*/
+inline int popLsb(TBitBoard & bb)
+{
+    int pos = __builtin_ctzll(bb);
+    bb &= bb - 1;
+    return pos;
+}
+
+// Non-sliding attacks, indexed by square ([color index][square] for pawns)
+extern TBitBoard knight_attacks[64];
+extern TBitBoard king_attacks[64];
+extern TBitBoard pawn_attacks[2][64];
+
+// Squares strictly between two squares on a common rank, file or diagonal
+// and the whole line through both of them, empty if they are not aligned
+extern TBitBoard between_bb[64][64];
+extern TBitBoard line_bb[64][64];
+
+/*
+* Magic bitboard entry of one square for one kind of slider. The relevant
+* blockers (mask) of an occupancy are hashed into an index of the square's
+* slice of the shared attack table. With BMI2 the index is extracted by
+* PEXT and the magic factor is not needed.
+*/
+struct Magic
+{
+    TBitBoard mask;
+    TBitBoard magic;
+    TBitBoard * attacks;
+    unsigned shift;
+
+    unsigned index(TBitBoard occupied) const {
+#ifdef __BMI2__
+        return _pext_u64(occupied, mask);
+#else
+        return ((occupied & mask) * magic) >> shift;
+#endif
+    }
+};
+
+extern Magic rook_magics[64];
+extern Magic bishop_magics[64];
+
+/*
+* Sliding attacks for the given occupancy. The attacked squares include the
+* first blocker in each direction, whatever its color.
+*/
+inline TBitBoard rookAttacks(int pos, TBitBoard occupied)
+{
+    const Magic & m = rook_magics[pos];
+    return m.attacks[m.index(occupied)];
+}
+
+inline TBitBoard bishopAttacks(int pos, TBitBoard occupied)
+{
+    const Magic & m = bishop_magics[pos];
+    return m.attacks[m.index(occupied)];
+}
+
+inline TBitBoard queenAttacks(int pos, TBitBoard occupied)
+{
+    return rookAttacks(pos, occupied) | bishopAttacks(pos, occupied);
+}
@@ -1,6 +1,5 @@
 #include <cstdio>
 #include <cstring>
-#include <list>
 #include <boost/format.hpp>
 #include <exception>
 #include <sstream>
@@ -8,9 +7,11 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/algorithm/string.hpp>
 #include <iostream>
+#include <algorithm>
 
 #include "chessboard.h"
 #include "chessplayer.h"
+#include "evaluation.h"
 
 
 #define COLORED
@@ -44,18 +45,41 @@ static const ChessBoard default_board = get_default_board();
 
 string Move::toString(void) const
 {
+    static const char promotion_name[] = " prnbqk";
     stringstream str;
     str << format("%1%%2%") % field_name[static_cast<size_t>(from)] % field_name[static_cast<size_t>(to)];
+    if (promotion != EMPTY)
+        str << promotion_name[promotion];
     return str.str();
 }
 
+Move Move::fromPacked(const ChessBoard & board, unsigned short packed)
+{
+    Move move;
+    move.from = packed & 0x3f;
+    move.to = (packed >> 6) & 0x3f;
+    move.promotion = packed >> 12;
+    move.figure = board.square[move.from];
+    move.capture = board.square[move.to];
+
+    if (FIGURE(move.figure) == PAWN) {
+        if (abs(move.to - move.from) == 16) {
+            move.figure = SET_PASSANT(move.figure);
+        } else if (move.capture == EMPTY && (move.to - move.from) % 8 != 0 && board.passant_pos != -1) {
+            // diagonal step to an empty square takes en passant
+            move.capture = board.square[board.passant_pos];
+        }
+    }
+    return move;
+}
+
 optional<Move> Move::fromString(const ChessBoard &board, const std::string & str)
 {
     optional<Move> result;
     result.reset(Move());
     int i = 0, j, l, n;
-    string lineIn = str, lineOut="    ";
-    copy_if(lineIn.begin(), lineIn.end(), lineOut.begin(),
+    string lineIn = str, lineOut;
+    copy_if(lineIn.begin(), lineIn.end(), back_inserter(lineOut),
         [](char c ) {
             return ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'));
         });
@@ -63,6 +87,10 @@ optional<Move> Move::fromString(const ChessBoard &board, const std::string & str
     if (lineIn != lineOut) {
         Global::instance().log("Gotcha");
     }
+    if (lineOut.size() < 4) {
+        result.reset();
+        return result;
+    }
 
 //    if(strncmp(&buf[i], "quit", 4) == 0)
 //        exit(0);
@@ -95,8 +123,20 @@ optional<Move> Move::fromString(const ChessBoard &board, const std::string & str
         else
             result->to = n * 8 + l;
     }
+    // optional promotion like "e7e8n", queen otherwise
+    if (result) {
+        result->promotion = EMPTY;
+        if (lineOut.size() > 4) {
+            switch (tolower(lineOut[4])) {
+                case 'q': result->promotion = QUEEN; break;
+                case 'r': result->promotion = ROOK; break;
+                case 'b': result->promotion = BISHOP; break;
+                case 'n': result->promotion = KNIGHT; break;
+                default: result.reset(); break;
+            }
+        }
+    }
     if (result) {
-        result->passant_pos_opponent = board.passant_pos;
         if (NOT board.isValidMove(board.next_move_color, *result)) {
             result.reset();
         }
@@ -146,6 +186,8 @@ bool Move::operator==(const Move & b) const
 		return false;
 	if(figure != b.figure)
 		return false;
+	if(promotion != b.promotion)
+		return false;
 		
 	return true;
 }
@@ -154,6 +196,7 @@ bool Move::operator==(const Move & b) const
 ChessBoard::ChessBoard()
 {
 	memset((void*)square, EMPTY, sizeof(square));
+    undo_stack.reserve(256);
 }
 
 void ChessBoard::print(Move move) const
@@ -206,6 +249,8 @@ void ChessBoard::loadFEN(const string& position)
     sposition.str(position);
 
     memset(square, 0, sizeof(square));
+    passant_pos = -1;
+    undo_stack.clear();
 
     sposition >> square_str;
     while (pos < 64 && local_pos >= 0) {
@@ -294,7 +339,7 @@ void ChessBoard::loadFEN(const string& position)
                     if (square[A8]) square[A8] = SET_UNMOVED(square[A8]);
                     break;
                 case 'Q':
-                    if (square[E8]) square[E8] = SET_UNMOVED(square[E8]);
+                    if (square[E1]) square[E1] = SET_UNMOVED(square[E1]);
                     if (square[A1]) square[A1] = SET_UNMOVED(square[A1]);
                     break;
                 default:
@@ -339,6 +384,8 @@ void ChessBoard::loadFEN(const string& position)
         square[static_cast<int>(white_king_pos)] = SET_MOVED(square[white_king_pos]);
     }
 
+    // moved kings may have changed castling rights
+    hash = computeHash();
 }
 
 std::string ChessBoard::toFEN() const
@@ -383,14 +430,15 @@ std::string ChessBoard::toFEN() const
 
 
     /// castlings
-    if (square[H1] && square[E1] && NOT IS_MOVED(square[H1]) && NOT IS_MOVED(square[E1]))
+    int rights = castlingRights();
+    if (rights & WHITE_SHORT)
         castlings += "K"; //short white castling
-    if (square[A1] && square[E1] && NOT IS_MOVED(square[A1]) && NOT IS_MOVED(square[E1]))
+    if (rights & WHITE_LONG)
         castlings += "Q"; //long white castling
-    if (square[H8] && square[E8] && NOT IS_MOVED(square[H8]) && NOT IS_MOVED(square[E8]))
-        castlings += "k"; //short white castling
-    if (square[A8] && square[E8] && NOT IS_MOVED(square[A8]) && NOT IS_MOVED(square[E8]))
-        castlings += "q"; //long white castling
+    if (rights & BLACK_SHORT)
+        castlings += "k"; //short black castling
+    if (rights & BLACK_LONG)
+        castlings += "q"; //long black castling
     if (castlings.empty()) {
         fen << "-";
     } else {
@@ -484,6 +532,7 @@ void ChessBoard::initDefaultSetup(void)
     move_number = 1;
 
     non_pawn_kick_moves_count = 0;
+    undo_stack.clear();
 
     refreshFigures();
 
@@ -491,100 +540,263 @@ void ChessBoard::initDefaultSetup(void)
 
 void ChessBoard::refreshFigures()
 {
-    figures_count[0] = 0;
-    figures_count[1] = 0;
+    memset(figures_bb, 0, sizeof(figures_bb));
+    memset(color_bb, 0, sizeof(color_bb));
+    occupied_bb = 0;
+    psq_score[MIDGAME] = psq_score[ENDGAME] = 0;
+    pawn_hash = 0;
     for (int pos = 0; pos < 64; pos++ ) {
 
         int figure = square[pos];
         if (figure) {
-            figures_count[IS_BLACK(figure) >> 4] ++;
+            figures_bb[COLOR_INDEX(figure)][FIGURE(figure)] |= BIT(pos);
+            color_bb[COLOR_INDEX(figure)] |= BIT(pos);
+            occupied_bb |= BIT(pos);
+            psq_score[MIDGAME] += piece_square.values[MIDGAME][COLOR_INDEX(figure)][FIGURE(figure)][pos];
+            psq_score[ENDGAME] += piece_square.values[ENDGAME][COLOR_INDEX(figure)][FIGURE(figure)][pos];
+            if (FIGURE(figure) == PAWN)
+                pawn_hash ^= zobrist.figures[COLOR_INDEX(figure)][PAWN][pos];
         }
-        if (FIGURE(figure) == KING) {
-            if (IS_BLACK(figure)) {
-                black_king_pos = pos;
-            } else {
-                white_king_pos = pos;
-            }
+    }
+
+    // everything else is read from the sets of squares
+    for (int color_index = 0; color_index < 2; color_index++)
+        figures_count[color_index] = popCount(color_bb[color_index]);
+    if (figures_bb[0][KING])
+        white_king_pos = bitScanForward(figures_bb[0][KING]);
+    if (figures_bb[1][KING])
+        black_king_pos = bitScanForward(figures_bb[1][KING]);
+    hash = computeHash();
+}
+
+int ChessBoard::castlingRights() const
+{
+    int rights = 0;
+    if (square[E1] && NOT IS_MOVED(square[E1])) {
+        if (square[H1] && NOT IS_MOVED(square[H1]))
+            rights |= WHITE_SHORT;
+        if (square[A1] && NOT IS_MOVED(square[A1]))
+            rights |= WHITE_LONG;
+    }
+    if (square[E8] && NOT IS_MOVED(square[E8])) {
+        if (square[H8] && NOT IS_MOVED(square[H8]))
+            rights |= BLACK_SHORT;
+        if (square[A8] && NOT IS_MOVED(square[A8]))
+            rights |= BLACK_LONG;
+    }
+    return rights;
+}
+
+uint64_t ChessBoard::computeHash() const
+{
+    uint64_t result = 0;
+    TBitBoard occupied = occupied_bb;
+    while (occupied) {
+        int pos = popLsb(occupied);
+        int figure = square[pos];
+        result ^= zobrist.figures[COLOR_INDEX(figure)][FIGURE(figure)][pos];
+    }
+    result ^= zobrist.castling[castlingRights()];
+    if (passant_pos != -1)
+        result ^= zobrist.passant[passant_pos % 8];
+    if (next_move_color == BLACK)
+        result ^= zobrist.black_to_move;
+    return result;
+}
+
+// Squares whose figures decide on the castling rights
+static const TBitBoard CASTLING_SQUARES = BIT(A1) | BIT(E1) | BIT(H1) | BIT(A8) | BIT(E8) | BIT(H8);
+
+void ChessBoard::setFigure(int pos, char figure)
+{
+    char old_figure = square[pos];
+    if (old_figure) {
+        figures_bb[COLOR_INDEX(old_figure)][FIGURE(old_figure)] ^= BIT(pos);
+        color_bb[COLOR_INDEX(old_figure)] ^= BIT(pos);
+        occupied_bb ^= BIT(pos);
+        hash ^= zobrist.figures[COLOR_INDEX(old_figure)][FIGURE(old_figure)][pos];
+        psq_score[MIDGAME] -= piece_square.values[MIDGAME][COLOR_INDEX(old_figure)][FIGURE(old_figure)][pos];
+        psq_score[ENDGAME] -= piece_square.values[ENDGAME][COLOR_INDEX(old_figure)][FIGURE(old_figure)][pos];
+        if (FIGURE(old_figure) == PAWN)
+            pawn_hash ^= zobrist.figures[COLOR_INDEX(old_figure)][PAWN][pos];
+    }
+    if (figure) {
+        figures_bb[COLOR_INDEX(figure)][FIGURE(figure)] ^= BIT(pos);
+        color_bb[COLOR_INDEX(figure)] ^= BIT(pos);
+        occupied_bb ^= BIT(pos);
+        hash ^= zobrist.figures[COLOR_INDEX(figure)][FIGURE(figure)][pos];
+        psq_score[MIDGAME] += piece_square.values[MIDGAME][COLOR_INDEX(figure)][FIGURE(figure)][pos];
+        psq_score[ENDGAME] += piece_square.values[ENDGAME][COLOR_INDEX(figure)][FIGURE(figure)][pos];
+        if (FIGURE(figure) == PAWN)
+            pawn_hash ^= zobrist.figures[COLOR_INDEX(figure)][PAWN][pos];
+    }
+    square[pos] = figure;
+}
+
+/*
+* Turns target squares of a figure into captures and (unless capture_only)
+* regular moves.
+*/
+template<bool capture_only>
+static inline void addMoves(const ChessBoard & board, int figure, int pos, TBitBoard targets,
+    MoveList & moves, MoveList & captures)
+{
+	Move new_move;
+	int target_pos;
+
+	new_move.figure = figure;
+	new_move.from = pos;
+	new_move.promotion = EMPTY;
+
+    TBitBoard hits = targets & board.pieces(OPPOSITE(figure));
+    while (hits) {
+        target_pos = popLsb(hits);
+        new_move.to = target_pos;
+        new_move.capture = board.square[target_pos];
+        captures.push_back(new_move);
+    }
+
+    if (NOT capture_only) {
+        TBitBoard quiet = targets & ~board.occupied_bb;
+        new_move.capture = EMPTY;
+        while (quiet) {
+            new_move.to = popLsb(quiet);
+            moves.push_back(new_move);
         }
     }
 }
+
+/*
+* Squares a figure other than the king may go to: with one checker only
+* those capturing or blocking it, none with two. A pinned figure stays on
+* the line through its king.
+*/
+static inline TBitBoard allowedTargets(int king_pos, TBitBoard checkers, TBitBoard pinned, int pos)
+{
+    TBitBoard allowed = ~static_cast<TBitBoard>(0);
+    if (checkers)
+        allowed = (checkers & (checkers - 1)) ? 0 : between_bb[king_pos][bitScanForward(checkers)] | checkers;
+    if (pinned & BIT(pos))
+        allowed &= line_bb[king_pos][pos];
+    return allowed;
+}
+
 template <bool capture_only>
-void MoveGenerator<capture_only>::getMoves(ChessBoard & board, int color, list<Move> & moves, list<Move> & captures)
+void MoveGenerator<capture_only>::getMoves(const ChessBoard & board, int color, MoveList & moves, MoveList & captures)
 {
 	int pos, figure;
-	
-	for(pos = 0; pos < 64; pos++)
+    int king_pos = color ? board.black_king_pos : board.white_king_pos;
+    TBitBoard checkers = board.attackers(king_pos, color, board.occupied_bb);
+    TBitBoard pinned = board.pinned(color);
+    TBitBoard own = board.pieces(color);
+
+    // in double check only the king moves
+    if (checkers & (checkers - 1))
+        own = BIT(king_pos);
+
+    while (own)
     {
-        if((figure = board.square[pos]) != EMPTY)
-		{
-			if(IS_BLACK(figure) == color)
-			{
-				switch(FIGURE(figure))
-				{
-					case PAWN:
-                        MoveGenerator<capture_only>::getPawnMoves(board, figure, pos, moves, captures);
-						break;
-					case ROOK:
-                        MoveGenerator<capture_only>::getRookMoves(board, figure, pos, moves, captures);
-						break;
-					case KNIGHT:
-                        MoveGenerator<capture_only>::getKnightMoves(board, figure, pos, moves, captures);
-						break;
-					case BISHOP:
-                        MoveGenerator<capture_only>::getBishopMoves(board, figure, pos, moves, captures);
-						break;
-					case QUEEN:
-                        MoveGenerator<capture_only>::getQueenMoves(board, figure, pos, moves, captures);
-						break;
-					case KING:
-                        MoveGenerator<capture_only>::getKingMoves(board, figure, pos, moves, captures);
-						break;
-					default:
-						break;
-				}
-			}
-		}
+        pos = popLsb(own);
+        figure = board.square[pos];
+        if (pos == king_pos)
+            MoveGenerator<capture_only>::getKingMoves(board, figure, pos, moves, captures);
+        else
+            addFigureMoves(board, figure, pos, allowedTargets(king_pos, checkers, pinned, pos), moves, captures);
 	}
-    // update necessary stuff here, lazy to do it in each subgenerations
-    for (Move & m : moves) {
-        m.passant_pos_opponent = board.passant_pos;
-        m.non_pawn_kick_moves_count_opponent = board.non_pawn_kick_moves_count;
+}
+
+template <bool capture_only>
+void MoveGenerator<capture_only>::getFigureMoves(const ChessBoard & board, int pos, MoveList & moves, MoveList & captures)
+{
+    int figure = board.square[pos];
+    if (figure == EMPTY)
+        return;
+    if (FIGURE(figure) == KING) {
+        MoveGenerator<capture_only>::getKingMoves(board, figure, pos, moves, captures);
+        return;
+    }
+
+    int color = IS_BLACK(figure);
+    int king_pos = color ? board.black_king_pos : board.white_king_pos;
+    TBitBoard checkers = board.attackers(king_pos, color, board.occupied_bb);
+    addFigureMoves(board, figure, pos, allowedTargets(king_pos, checkers, board.pinned(color), pos),
+                   moves, captures);
+}
+
+template <bool capture_only>
+void MoveGenerator<capture_only>::addFigureMoves(const ChessBoard & board, int figure, int pos, TBitBoard allowed,
+                                                 MoveList & moves, MoveList & captures)
+{
+    switch(FIGURE(figure))
+    {
+        case PAWN:
+            MoveGenerator<capture_only>::getPawnMoves(board, figure, pos, allowed, moves, captures);
+            break;
+        case ROOK:
+            MoveGenerator<capture_only>::getRookMoves(board, figure, pos, allowed, moves, captures);
+            break;
+        case KNIGHT:
+            MoveGenerator<capture_only>::getKnightMoves(board, figure, pos, allowed, moves, captures);
+            break;
+        case BISHOP:
+            MoveGenerator<capture_only>::getBishopMoves(board, figure, pos, allowed, moves, captures);
+            break;
+        case QUEEN:
+            MoveGenerator<capture_only>::getQueenMoves(board, figure, pos, allowed, moves, captures);
+            break;
+        default:
+            break;
     }
-    for (Move & m : captures) {
-        m.passant_pos_opponent = board.passant_pos;
-        m.non_pawn_kick_moves_count_opponent = board.non_pawn_kick_moves_count;
+}
+
+/*
+* Adds a pawn move, a move to the last row is added once per promotion
+*/
+static inline void addPawnMove(Move & new_move, MoveList & list)
+{
+    if (new_move.to / 8 == 0 || new_move.to / 8 == 7) {
+        static const int promotions[] = {QUEEN, KNIGHT, ROOK, BISHOP};
+        for (int promotion : promotions) {
+            new_move.promotion = promotion;
+            list.push_back(new_move);
+        }
+        new_move.promotion = EMPTY;
+    } else {
+        list.push_back(new_move);
     }
 }
 template<bool capture_only>
-void MoveGenerator<capture_only>::getPawnMoves(ChessBoard & board, int figure, int pos, list<Move> & moves, list<Move> & captures)
+void MoveGenerator<capture_only>::getPawnMoves(const ChessBoard & board, int figure, int pos, TBitBoard allowed,
+                                               MoveList & moves, MoveList & captures)
 {
 	Move new_move;
-    char target_pos, target_figure;
+    int target_pos;
 
 	// Of course, we only have to set this once
 	new_move.figure = figure;
 	new_move.from = pos;
+	new_move.promotion = EMPTY;
 
 	// 1. One step ahead
 	target_pos = IS_BLACK(figure) ? pos - 8 : pos + 8;
     if(NOT capture_only && (target_pos >= 0) && (target_pos < 64))
 	{
-        if((target_figure = board.square[target_pos]) == EMPTY)
+        if(board.square[target_pos] == EMPTY)
 		{
 			new_move.to = target_pos;
-			new_move.capture = target_figure;
-			moves.push_back(new_move);
-			
+			new_move.capture = EMPTY;
+			if (allowed & BIT(target_pos))
+				addPawnMove(new_move, moves);
+
 			// 2. Two steps ahead if unmoved
 			if(!IS_MOVED(figure))
 			{
 				target_pos = IS_BLACK(figure) ? pos - 16 : pos + 16;
 				if((target_pos >= 0) && (target_pos < 64))
 				{
-                    if((target_figure = board.square[target_pos]) == EMPTY)
+                    if(board.square[target_pos] == EMPTY && (allowed & BIT(target_pos)))
 					{
 						new_move.to = target_pos;
-						new_move.capture = target_figure;
 
 						// set passant attribute and clear it later
 						new_move.figure = SET_PASSANT(figure);
@@ -595,1103 +807,304 @@ void MoveGenerator<capture_only>::getPawnMoves(ChessBoard & board, int figure, i
 			} // END 2.
 		}
 	} // END 1.
-	
-	// 3. Forward capture (White left; Black right)
-	if(pos % 8 != 0)
+
+	// 3. Forward captures
+    TBitBoard hits = pawn_attacks[COLOR_INDEX(figure)][pos] & board.pieces(OPPOSITE(figure)) & allowed;
+    while (hits) {
+        target_pos = popLsb(hits);
+        new_move.to = target_pos;
+        new_move.capture = board.square[target_pos];
+        addPawnMove(new_move, captures);
+    }
+
+	// 4. En passant, the opponent's pawn has just passed by our side
+    int passant_pos = board.passant_pos;
+    if (passant_pos != -1 && passant_pos / 8 == pos / 8 && abs(passant_pos - pos) == 1)
 	{
-		target_pos = IS_BLACK(figure) ? pos - 9 : pos + 7;
-		if((target_pos >= 0) && (target_pos < 64))
-		{
-            if((target_figure = board.square[target_pos]) != EMPTY)
-			{
-				if(IS_BLACK(target_figure) != IS_BLACK(figure))
-				{
-					new_move.to = target_pos;
-					new_move.capture = target_figure;
-					captures.push_back(new_move);
-				}
-			}
-			else
-			{
-				// En passant?
-                target_figure = board.square[pos - 1];
-				if(IS_PASSANT(target_figure))
-				{
-					if(IS_BLACK(target_figure) != IS_BLACK(figure))
-					{
-						new_move.to = target_pos;
-						new_move.capture = target_figure;
-						captures.push_back(new_move);
-					}				
-				}
-			}
+        char target_figure = board.square[passant_pos];
+        target_pos = IS_BLACK(figure) ? passant_pos - 8 : passant_pos + 8;
+        if(IS_PASSANT(target_figure) && IS_BLACK(target_figure) != IS_BLACK(figure)
+                && board.square[target_pos] == EMPTY)
+		{
+            // two pawns leave the king's rank or diagonal at once and the
+            // captured one may be the checker, so the position after the
+            // capture is looked at as a whole
+            int king_pos = IS_BLACK(figure) ? board.black_king_pos : board.white_king_pos;
+            TBitBoard occupied = (board.occupied_bb ^ BIT(pos) ^ BIT(passant_pos)) | BIT(target_pos);
+            if (board.attackers(king_pos, figure, occupied) & ~BIT(passant_pos))
+                return;
+
+			new_move.to = target_pos;
+			new_move.capture = target_figure;
+			captures.push_back(new_move);
 		}
 	}
-	
-	// 4. Forward capture (White right; Black left)
-	if(pos % 8 != 7)
-	{
-		target_pos = IS_BLACK(figure) ? pos - 7 : pos + 9;
-		if((target_pos >= 0) && (target_pos < 64))
-		{
-            if((target_figure = board.square[target_pos]) != EMPTY)
-			{
-				if(IS_BLACK(target_figure) != IS_BLACK(figure))
-				{
-					new_move.to = target_pos;
-					new_move.capture = target_figure;
-					captures.push_back(new_move);
-				}
-			}
-			else
-			{
-				// En passant?
-                target_figure = board.square[pos + 1];
-				if(IS_PASSANT(target_figure))
-				{
-					if(IS_BLACK(target_figure) != IS_BLACK(figure))
-					{
-						new_move.to = target_pos;
-						new_move.capture = target_figure;
-						captures.push_back(new_move);
-                    }
-				}
-			}
-		}
-	}	
 }
 template<bool capture_only>
-void MoveGenerator<capture_only>::getRookMoves(ChessBoard & board, int figure, int pos, list<Move> & moves, list<Move> & captures)
+void MoveGenerator<capture_only>::getRookMoves(const ChessBoard & board, int figure, int pos, TBitBoard allowed,
+    MoveList & moves, MoveList & captures)
 {
-	Move new_move;
-	int target_pos, target_figure, end;
+    addMoves<capture_only>(board, figure, pos, rookAttacks(pos, board.occupied_bb) & allowed, moves, captures);
+}
 
-	// Of course, we only have to set this once
-	new_move.figure = figure;
-	new_move.from = pos;
+template<bool capture_only>
+void MoveGenerator<capture_only>::getKnightMoves(const ChessBoard & board, int figure, int pos, TBitBoard allowed,
+    MoveList & moves, MoveList & captures)
+{
+    addMoves<capture_only>(board, figure, pos, knight_attacks[pos] & allowed, moves, captures);
+}
 
-	// 1. Move up
-	for(target_pos = pos + 8; target_pos < 64; target_pos += 8)
-	{
-        if((target_figure = board.square[target_pos]) != EMPTY)
-		{
-			if(IS_BLACK(figure) != IS_BLACK(target_figure))
-			{
-				new_move.to = target_pos;
-				new_move.capture = target_figure;
-				captures.push_back(new_move);
-			}
-			
-			break;
-		}
-		else
-		{
-			new_move.to = target_pos;
-			new_move.capture = target_figure;
-			moves.push_back(new_move);
-		}
-	}
+template<bool capture_only>
+void MoveGenerator<capture_only>::getBishopMoves(const ChessBoard & board, int figure, int pos, TBitBoard allowed,
+    MoveList & moves, MoveList & captures)
+{
+    addMoves<capture_only>(board, figure, pos, bishopAttacks(pos, board.occupied_bb) & allowed, moves, captures);
+}
 
-	// 2. Move down
-	for(target_pos = pos - 8; target_pos >= 0; target_pos -= 8)
-	{	
-        if((target_figure = board.square[target_pos]) != EMPTY)
-		{
-			if(IS_BLACK(figure) != IS_BLACK(target_figure))
-			{
-				new_move.to = target_pos;
-				new_move.capture = target_figure;
-				captures.push_back(new_move);
-			}
-			
-			break;
-		}
-		else
-		{
-			new_move.to = target_pos;
-			new_move.capture = target_figure;
-			moves.push_back(new_move);
-		}
-	}
+template<bool capture_only>
+void MoveGenerator<capture_only>::getQueenMoves(const ChessBoard & board, int figure, int pos, TBitBoard allowed,
+    MoveList & moves, MoveList & captures)
+{
+	// Queen is just the "cartesian product" of Rook and Bishop
+    addMoves<capture_only>(board, figure, pos, queenAttacks(pos, board.occupied_bb) & allowed, moves, captures);
+}
 
-	// 3. Move left
-	for(target_pos = pos - 1, end = pos - (pos % 8); target_pos >= end; target_pos--)
-	{
-        if((target_figure = board.square[target_pos]) != EMPTY)
-		{
-			if(IS_BLACK(figure) != IS_BLACK(target_figure))
-			{
-				new_move.to = target_pos;
-				new_move.capture = target_figure;
-				captures.push_back(new_move);
-			}
-			
-			break;
-		}
-		else
-		{
-			new_move.to = target_pos;
-			new_move.capture = target_figure;
-			moves.push_back(new_move);
-		}
-	}
+template<bool capture_only>
+void MoveGenerator<capture_only>::getKingMoves(const ChessBoard & board, int figure, int pos, MoveList & moves, MoveList & captures)
+{
+    Move new_move;
+    int target_pos, target_figure;
+
+    // the king does not shield the squares behind it from a slider
+    TBitBoard targets = king_attacks[pos] & ~board.pieces(figure);
+    TBitBoard safe = 0, occupied = board.occupied_bb ^ BIT(pos);
+    while (targets) {
+        target_pos = popLsb(targets);
+        if (NOT board.attackers(target_pos, figure, occupied))
+            safe |= BIT(target_pos);
+    }
+    addMoves<capture_only>(board, figure, pos, safe, moves, captures);
+
+    if (capture_only)
+        return;
+
+    // Of course, we only have to set this once
+    new_move.figure = figure;
+    new_move.from = pos;
+    new_move.promotion = EMPTY;
+
+    // 5. Castling: the king may not start in, pass or land on an attacked
+    // square, the rook may be attacked
+    if(!IS_MOVED(figure) && !board.isVulnerable(pos, figure))
+    {
+        // short
+        target_pos = IS_BLACK(figure) ? F8 : F1;
+        if((board.square[target_pos] == EMPTY) && !board.isVulnerable(target_pos, figure))
+        {
+            target_pos = IS_BLACK(figure) ? G8 : G1;
+            if((board.square[target_pos] == EMPTY) && !board.isVulnerable(target_pos, figure))
+            {
+                target_pos = IS_BLACK(figure) ? H8 : H1;
+                target_figure = board.square[target_pos];
+                if(!IS_MOVED(target_figure) && (FIGURE(target_figure) == ROOK))
+                {
+                    if(IS_BLACK(target_figure) == IS_BLACK(figure))
+                    {
+                        new_move.capture = EMPTY;
+                        new_move.to = IS_BLACK(figure) ? G8 : G1;
+                        moves.push_back(new_move);
+                    }
+                }
+            }
+        }
+
+        // long, the king does not pass B1
+        target_pos = IS_BLACK(figure) ? B8 : B1;
+        if(board.square[target_pos] == EMPTY)
+        {
+            target_pos = IS_BLACK(figure) ? C8 : C1;
+            if((board.square[target_pos] == EMPTY) && !board.isVulnerable(target_pos, figure))
+            {
+                target_pos = IS_BLACK(figure) ? D8 : D1;
+                if((board.square[target_pos] == EMPTY) && !board.isVulnerable(target_pos, figure))
+                {
+                    target_pos = IS_BLACK(figure) ? A8 : A1;
+                    target_figure = board.square[target_pos];
+                    if(!IS_MOVED(target_figure) && (FIGURE(target_figure) == ROOK))
+                    {
+                        if(IS_BLACK(target_figure) == IS_BLACK(figure))
+                        {
+                            new_move.capture = EMPTY;
+                            new_move.to = IS_BLACK(figure) ? C8 : C1;
+                            moves.push_back(new_move);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+bool ChessBoard::isVulnerable(int pos, int color) const
+{
+    int opponent = COLOR_INDEX(OPPOSITE(color));
+    const TBitBoard * opponent_bb = figures_bb[opponent];
+
+    // Pawns, knights and kings attack the same squares in both directions
+    if (pawn_attacks[COLOR_INDEX(color)][pos] & opponent_bb[PAWN])
+        return true;
+    if (knight_attacks[pos] & opponent_bb[KNIGHT])
+        return true;
+    if (king_attacks[pos] & opponent_bb[KING])
+        return true;
+
+    // Sliders, looking from the square to the first blocker
+    if (bishopAttacks(pos, occupied_bb) & (opponent_bb[BISHOP] | opponent_bb[QUEEN]))
+        return true;
+    if (rookAttacks(pos, occupied_bb) & (opponent_bb[ROOK] | opponent_bb[QUEEN]))
+        return true;
+
+    return false;
+}
+
+TBitBoard ChessBoard::attackers(int pos, int color, TBitBoard occupied) const
+{
+    const TBitBoard * opponent_bb = figures_bb[COLOR_INDEX(OPPOSITE(color))];
+
+    return (pawn_attacks[COLOR_INDEX(color)][pos] & opponent_bb[PAWN])
+         | (knight_attacks[pos] & opponent_bb[KNIGHT])
+         | (king_attacks[pos] & opponent_bb[KING])
+         | (bishopAttacks(pos, occupied) & (opponent_bb[BISHOP] | opponent_bb[QUEEN]) & occupied)
+         | (rookAttacks(pos, occupied) & (opponent_bb[ROOK] | opponent_bb[QUEEN]) & occupied);
+}
+
+TBitBoard ChessBoard::attackersTo(int pos, TBitBoard occupied) const
+{
+    const TBitBoard queens = figures_bb[0][QUEEN] | figures_bb[1][QUEEN];
+
+    return ((pawn_attacks[0][pos] & figures_bb[1][PAWN])
+          | (pawn_attacks[1][pos] & figures_bb[0][PAWN])
+          | (knight_attacks[pos] & (figures_bb[0][KNIGHT] | figures_bb[1][KNIGHT]))
+          | (king_attacks[pos] & (figures_bb[0][KING] | figures_bb[1][KING]))
+          | (bishopAttacks(pos, occupied) & (figures_bb[0][BISHOP] | figures_bb[1][BISHOP] | queens))
+          | (rookAttacks(pos, occupied) & (figures_bb[0][ROOK] | figures_bb[1][ROOK] | queens)))
+          & occupied;
+}
+
+// Values the exchange is counted in, the king only takes what nobody
+// defends any more
+static const int exchange_values[7] = {
+    0, PAWN_VALUE, ROOK_VALUE, KNIGHT_VALUE, BISHOP_VALUE, QUEEN_VALUE, KING_VALUE
+};
+
+// Attackers are taken in this order
+static const int exchange_order[6] = {PAWN, BISHOP, KNIGHT, ROOK, QUEEN, KING};
+
+int ChessBoard::staticExchange(const Move & move) const
+{
+    // gain[n]: material of the side making the n-th capture, if it is the last
+    int gain[34];
+    int depth = 0;
+
+    TBitBoard occupied = occupied_bb;
+    TBitBoard from_set = BIT(move.from);
+    int attacker = FIGURE(move.figure);
+    int side = COLOR_INDEX(move.figure);
+
+    gain[0] = exchange_values[FIGURE(move.capture)];
+    if (move.promotion) {
+        gain[0] += exchange_values[move.promotion] - PAWN_VALUE;
+        attacker = move.promotion;
+    }
+    // en passant, the pawn taken is not on the target square
+    if (move.capture && square[move.to] == EMPTY)
+        occupied ^= BIT(passant_pos);
+
+    do {
+        depth++;
+        gain[depth] = exchange_values[attacker] - gain[depth - 1];
+        // neither side is going to do better by going on
+        if (max(-gain[depth - 1], gain[depth]) < 0)
+            break;
+
+        occupied ^= from_set;
+        // sliders behind the figure gone may see the square now
+        TBitBoard attacking = attackersTo(move.to, occupied);
+        side ^= 1;
+        from_set = 0;
+        for (int figure : exchange_order) {
+            TBitBoard candidates = attacking & figures_bb[side][figure];
+            if (candidates) {
+                from_set = candidates & (0 - candidates);
+                attacker = figure;
+                break;
+            }
+        }
+    } while (from_set);
+
+    while (--depth)
+        gain[depth - 1] = -max(-gain[depth - 1], gain[depth]);
+    return gain[0];
+}
+
+TBitBoard ChessBoard::pinned(int color) const
+{
+    const TBitBoard * opponent_bb = figures_bb[COLOR_INDEX(OPPOSITE(color))];
+    int king_pos = color ? black_king_pos : white_king_pos;
+    TBitBoard result = 0;
+
+    // opponent sliders which would see the king on an empty board
+    TBitBoard snipers = (rookAttacks(king_pos, 0) & (opponent_bb[ROOK] | opponent_bb[QUEEN]))
+                      | (bishopAttacks(king_pos, 0) & (opponent_bb[BISHOP] | opponent_bb[QUEEN]));
+    while (snipers) {
+        TBitBoard blockers = between_bb[king_pos][popLsb(snipers)] & occupied_bb;
+        if (blockers && NOT (blockers & (blockers - 1)) && (blockers & pieces(color)))
+            result |= blockers;
+    }
+    return result;
+}
 
-	// 4. Move right
-	for(target_pos = pos + 1, end = pos + (8 - pos % 8); target_pos < end; target_pos++)
+bool ChessBoard::isValidMove(int color, Move & move) const
+{
+    int figure = square[move.from];
+    if (figure == EMPTY || IS_BLACK(figure) != color)
+        return false;
+
+    MoveList regulars;
+    MoveGenerator<false>::getFigureMoves(*this, move.from, regulars, regulars);
+
+	for(const Move & generated : regulars)
 	{
-        if((target_figure = board.square[target_pos]) != EMPTY)
-		{
-			if(IS_BLACK(figure) != IS_BLACK(target_figure))
-			{
-				new_move.to = target_pos;
-				new_move.capture = target_figure;
-				captures.push_back(new_move);
-			}
-			
-			break;
-		}
-		else
+		if(move.to == generated.to
+                && (move.promotion == EMPTY || move.promotion == generated.promotion))
 		{
-			new_move.to = target_pos;
-			new_move.capture = target_figure;
-			moves.push_back(new_move);
+            // this garanties that our move is same as one of generated
+            move = generated;
+            return true;
 		}
 	}
+
+	return false;
 }
 
-template<bool capture_only>
-void MoveGenerator<capture_only>::getKnightMoves(ChessBoard & board, int figure, int pos, list<Move> & moves, list<Move> & captures)
+ChessPlayer::Status ChessBoard::getPlayerStatus(int color) const
 {
-	Move new_move;
-	int target_pos, target_figure, row, col;
+    if (non_pawn_kick_moves_count >= 50 || isRepetition(2)) {
+        return ChessPlayer::Draw;
+    }
+    MoveList regulars;
 
-	// Of course, we only have to set this once
-	new_move.figure = figure;
-	new_move.from = pos;
+    MoveGenerator<false>::getMoves(*this, color, regulars, regulars);
 
-	// Determine row and column
-	row = pos / 8;
-	col = pos % 8;
-
-	// 1. Upper positions
-	if(row < 6)
-	{
-		// right
-		if(col < 7)
-		{
-			target_pos = pos + 17;
-		
-            if((target_figure = board.square[target_pos]) != EMPTY)
-			{
-				if(IS_BLACK(figure) != IS_BLACK(target_figure))
-				{
-					new_move.capture = target_figure;
-					new_move.to = target_pos;
-					captures.push_back(new_move);
-				}
-			}
-			else
-			{
-				new_move.capture = target_figure;
-				new_move.to = target_pos;
-				moves.push_back(new_move);
-			}
-		}
-		
-		// left
-		if(col > 0)
-		{
-			target_pos = pos + 15;
-		
-            if((target_figure = board.square[target_pos]) != EMPTY)
-			{
-				if(IS_BLACK(figure) != IS_BLACK(target_figure))
-				{
-					new_move.capture = target_figure;
-					new_move.to = target_pos;
-					captures.push_back(new_move);
-				}
-			}
-			else
-			{
-				new_move.capture = target_figure;
-				new_move.to = target_pos;
-				moves.push_back(new_move);
-			}		
-		}
-	}
-	
-	// 2. Lower positions
-	if(row > 1)
-	{
-		// right
-		if(col < 7)
-		{
-			target_pos = pos - 15;
-		
-            if((target_figure = board.square[target_pos]) != EMPTY)
-			{
-				if(IS_BLACK(figure) != IS_BLACK(target_figure))
-				{
-					new_move.capture = target_figure;
-					new_move.to = target_pos;
-					captures.push_back(new_move);
-				}
-			}
-			else
-			{
-				new_move.capture = target_figure;
-				new_move.to = target_pos;
-				moves.push_back(new_move);
-			}
-		}
-		
-		// left
-		if(col > 0)
-		{
-			target_pos = pos - 17;
-		
-            if((target_figure = board.square[target_pos]) != EMPTY)
-			{
-				if(IS_BLACK(figure) != IS_BLACK(target_figure))
-				{
-					new_move.capture = target_figure;
-					new_move.to = target_pos;
-					captures.push_back(new_move);
-				}
-			}
-			else
-			{
-				new_move.capture = target_figure;
-				new_move.to = target_pos;
-				moves.push_back(new_move);
-			}		
-		}
-	}
-
-	// 3. Right positions
-	if(col < 6)
-	{
-		// up
-		if(row < 7)
-		{
-			target_pos = pos + 10;
-		
-            if((target_figure = board.square[target_pos]) != EMPTY)
-			{
-				if(IS_BLACK(figure) != IS_BLACK(target_figure))
-				{
-					new_move.capture = target_figure;
-					new_move.to = target_pos;
-					captures.push_back(new_move);
-				}
-			}
-			else
-			{
-				new_move.capture = target_figure;
-				new_move.to = target_pos;
-				moves.push_back(new_move);
-			}
-		}
-		
-		// down
-		if(row > 0)
-		{
-			target_pos = pos - 6;
-		
-            if((target_figure = board.square[target_pos]) != EMPTY)
-			{
-				if(IS_BLACK(figure) != IS_BLACK(target_figure))
-				{
-					new_move.capture = target_figure;
-					new_move.to = target_pos;
-					captures.push_back(new_move);
-				}
-			}
-			else
-			{
-				new_move.capture = target_figure;
-				new_move.to = target_pos;
-				moves.push_back(new_move);
-			}		
-		}
-	}
-
-	// 4. Left positions
-	if(col > 1)
-	{
-		// up
-		if(row < 7)
-		{
-			target_pos = pos + 6;
-		
-            if((target_figure = board.square[target_pos]) != EMPTY)
-			{
-				if(IS_BLACK(figure) != IS_BLACK(target_figure))
-				{
-					new_move.capture = target_figure;
-					new_move.to = target_pos;
-					captures.push_back(new_move);
-				}
-			}
-			else
-			{
-				new_move.capture = target_figure;
-				new_move.to = target_pos;
-				moves.push_back(new_move);
-			}
-		}
-		
-		// down
-		if(row > 0)
-		{
-			target_pos = pos - 10;
-		
-            if((target_figure = board.square[target_pos]) != EMPTY)
-			{
-				if(IS_BLACK(figure) != IS_BLACK(target_figure))
-				{
-					new_move.capture = target_figure;
-					new_move.to = target_pos;
-					captures.push_back(new_move);
-				}
-			}
-			else
-			{
-				new_move.capture = target_figure;
-				new_move.to = target_pos;
-				moves.push_back(new_move);
-			}		
-		}
-	}	
-}
-
-template<bool capture_only>
-void MoveGenerator<capture_only>::getBishopMoves(ChessBoard & board, int figure, int pos, list<Move> & moves, list<Move> & captures)
-{
-	Move new_move;
-	int target_pos, target_figure, row, col, i, j;
-
-	// Of course, we only have to set this once
-	new_move.figure = figure;
-	new_move.from = pos;
-
-	// Determine row and column
-	row = pos / 8;
-	col = pos % 8;
-
-	// 1. Go north-east
-	for(i = row + 1, j = col + 1; (i < 8) && (j < 8); i++, j++)
-	{
-		target_pos = i * 8 + j;
-        if((target_figure = board.square[target_pos]) != EMPTY)
-		{
-			if(IS_BLACK(figure) != IS_BLACK(target_figure))
-			{
-				new_move.to = target_pos;
-				new_move.capture = target_figure;
-				captures.push_back(new_move);
-			}
-
-			break;
-		}
-		else
-		{
-			new_move.to = target_pos;
-			new_move.capture = target_figure;
-			moves.push_back(new_move);
-		}
-	}
-	
-	// 2. Go south-east
-	for(i = row - 1, j = col + 1; (i >= 0) && (j < 8); i--, j++)
-	{
-		target_pos = i * 8 + j;
-        if((target_figure = board.square[target_pos]) != EMPTY)
-		{
-			if(IS_BLACK(figure) != IS_BLACK(target_figure))
-			{
-				new_move.to = target_pos;
-				new_move.capture = target_figure;
-				captures.push_back(new_move);
-			}
-			
-			break;
-		}
-		else
-		{
-			new_move.to = target_pos;
-			new_move.capture = target_figure;
-			moves.push_back(new_move);
-		}
-	}
-
-	// 3. Go south-west
-	for(i = row - 1, j = col - 1; (i >= 0) && (j >= 0); i--, j--)
-	{
-		target_pos = i * 8 + j;
-        if((target_figure = board.square[target_pos]) != EMPTY)
-		{
-			if(IS_BLACK(figure) != IS_BLACK(target_figure))
-			{
-				new_move.to = target_pos;
-				new_move.capture = target_figure;
-				captures.push_back(new_move);
-			}
-			
-			break;
-		}
-		else
-		{
-			new_move.to = target_pos;
-			new_move.capture = target_figure;
-			moves.push_back(new_move);
-		}
-	}
-
-	// 4. Go north-west
-	for(i = row + 1, j = col - 1; (i < 8) && (j >= 0); i++, j--)
-	{
-		target_pos = i * 8 + j;
-        if((target_figure = board.square[target_pos]) != EMPTY)
-		{
-			if(IS_BLACK(figure) != IS_BLACK(target_figure))
-			{
-				new_move.to = target_pos;
-				new_move.capture = target_figure;
-				captures.push_back(new_move);
-			}
-			
-			break;
-		}
-		else
-		{
-			new_move.to = target_pos;
-			new_move.capture = target_figure;
-			moves.push_back(new_move);
-		}
-	}
-}
-
-template<bool capture_only>
-void MoveGenerator<capture_only>::getQueenMoves(ChessBoard & board, int figure, int pos, list<Move> & moves, list<Move> & captures)
-{
-	// Queen is just the "cartesian product" of Rook and Bishop
-    MoveGenerator<capture_only>::getRookMoves(board, figure, pos, moves, captures);
-    MoveGenerator<capture_only>::getBishopMoves(board, figure, pos, moves, captures);
-}
-
-template<bool capture_only>
-void MoveGenerator<capture_only>::getKingMoves(ChessBoard & board, int figure, int pos, list<Move> & moves, list<Move> & captures)
-{
-	Move new_move;
-	int target_pos, target_figure, row, col;
-
-	// Of course, we only have to set this once
-	new_move.figure = figure;
-	new_move.from = pos;
-
-	// Determine row and column
-	row = pos / 8;
-	col = pos % 8;
-
-	// 1. Move left
-	if(col > 0)
-	{
-		// 1.1 up
-		if(row < 7)
-		{
-			target_pos = pos + 7;
-            if((target_figure = board.square[target_pos]) != EMPTY)
-			{
-				if(IS_BLACK(target_figure) != IS_BLACK(figure))
-				{
-					new_move.capture = target_figure;
-					new_move.to = target_pos;
-					captures.push_back(new_move);
-				}
-			}
-			else
-			{
-				new_move.to = target_pos;
-				new_move.capture = target_figure;
-				moves.push_back(new_move);
-			}
-		}
-		
-		// 1.2 middle
-		target_pos = pos - 1;
-        if((target_figure = board.square[target_pos]) != EMPTY)
-		{
-			if(IS_BLACK(target_figure) != IS_BLACK(figure))
-			{
-				new_move.capture = target_figure;
-				new_move.to = target_pos;
-				captures.push_back(new_move);
-			}
-		}
-		else
-		{
-			new_move.to = target_pos;
-			new_move.capture = target_figure;
-			moves.push_back(new_move);
-		}
-		
-		// 1.3 down
-		if(row > 0)
-		{
-			target_pos = pos - 9;
-            if((target_figure = board.square[target_pos]) != EMPTY)
-			{
-				if(IS_BLACK(target_figure) != IS_BLACK(figure))
-				{
-					new_move.capture = target_figure;
-					new_move.to = target_pos;
-					captures.push_back(new_move);
-				}
-			}
-			else
-			{
-				new_move.to = target_pos;
-				new_move.capture = target_figure;
-				moves.push_back(new_move);
-			}
-		}
-	}
-	
-	// 2. Move right
-	if(col < 7)
-	{
-		// 2.1 up
-		if(row < 7)
-		{
-			target_pos = pos + 9;
-            if((target_figure = board.square[target_pos]) != EMPTY)
-			{
-				if(IS_BLACK(target_figure) != IS_BLACK(figure))
-				{
-					new_move.capture = target_figure;
-					new_move.to = target_pos;
-					captures.push_back(new_move);
-				}
-			}
-			else
-			{
-				new_move.to = target_pos;
-				new_move.capture = target_figure;
-				moves.push_back(new_move);
-			}
-		}
-		
-		// 2.2 middle
-		target_pos = pos + 1;
-        if((target_figure = board.square[target_pos]) != EMPTY)
-		{
-			if(IS_BLACK(target_figure) != IS_BLACK(figure))
-			{
-				new_move.capture = target_figure;
-				new_move.to = target_pos;
-				captures.push_back(new_move);
-			}
-		}
-		else
-		{
-			new_move.to = target_pos;
-			new_move.capture = target_figure;
-			moves.push_back(new_move);
-		}
-		
-		// 2.3 down
-		if(row > 0)
-		{
-			target_pos = pos - 7;
-            if((target_figure = board.square[target_pos]) != EMPTY)
-			{
-				if(IS_BLACK(target_figure) != IS_BLACK(figure))
-				{
-					new_move.capture = target_figure;
-					new_move.to = target_pos;
-					captures.push_back(new_move);
-				}
-			}
-			else
-			{
-				new_move.to = target_pos;
-				new_move.capture = target_figure;
-				moves.push_back(new_move);
-			}
-		}
-	}
-	
-	// 3. straight up
-	if(row < 7)
-	{
-		// 2.2 middle
-		target_pos = pos + 8;
-        if((target_figure = board.square[target_pos]) != EMPTY)
-		{
-			if(IS_BLACK(target_figure) != IS_BLACK(figure))
-			{
-				new_move.capture = target_figure;
-				new_move.to = target_pos;
-				captures.push_back(new_move);
-			}
-		}
-		else
-		{
-			new_move.to = target_pos;
-			new_move.capture = target_figure;
-			moves.push_back(new_move);
-		}	
-	}
-	
-	// 4. straight down
-	if(row > 0)
-	{
-		// 2.2 middle
-		target_pos = pos - 8;
-        if((target_figure = board.square[target_pos]) != EMPTY)
-		{
-			if(IS_BLACK(target_figure) != IS_BLACK(figure))
-			{
-				new_move.capture = target_figure;
-				new_move.to = target_pos;
-				captures.push_back(new_move);
-			}
-		}
-		else
-		{
-			new_move.to = target_pos;
-			new_move.capture = target_figure;
-			moves.push_back(new_move);
-		}	
-	}
-
-	// 5. Castling
-    if(!IS_MOVED(figure) && !board.isVulnerable(pos, figure))
-	{
-		// short
-		target_pos = IS_BLACK(figure) ? F8 : F1;
-        if((board.square[target_pos] == EMPTY) && !board.isVulnerable(target_pos, figure))
-		{
-			target_pos = IS_BLACK(figure) ? G8 : G1;
-            if((board.square[target_pos] == EMPTY) && !board.isVulnerable(target_pos, figure))
-			{
-				target_pos = IS_BLACK(figure) ? H8 : H1;
-                target_figure = board.square[target_pos];
-                if(!IS_MOVED(target_figure) && (FIGURE(target_figure) == ROOK) && !board.isVulnerable(target_pos, figure))
-				{
-					if(IS_BLACK(target_figure) == IS_BLACK(figure))
-					{
-						new_move.capture = EMPTY;
-						new_move.to = IS_BLACK(figure) ? G8 : G1;
-						moves.push_back(new_move);
-					}
-				}
-			}
-		}
-		
-		// long
-		target_pos = IS_BLACK(figure) ? B8 : B1;
-        if((board.square[target_pos] == EMPTY) && !board.isVulnerable(target_pos, figure))
-		{
-			target_pos = IS_BLACK(figure) ? C8 : C1;
-            if((board.square[target_pos] == EMPTY) && !board.isVulnerable(target_pos, figure))
-			{
-				target_pos = IS_BLACK(figure) ? D8 : D1;
-                if((board.square[target_pos] == EMPTY) && !board.isVulnerable(target_pos, figure))
-				{
-					target_pos = IS_BLACK(figure) ? A8 : A1;
-                    target_figure = board.square[target_pos];
-                    if(!IS_MOVED(target_figure) && (FIGURE(target_figure) == ROOK) && !board.isVulnerable(target_pos, figure))
-					{
-						if(IS_BLACK(target_figure) == IS_BLACK(figure))
-						{
-							new_move.capture = EMPTY;
-							new_move.to = IS_BLACK(figure) ? C8 : C1;
-							moves.push_back(new_move);
-						}
-					}
-				}
-			}
-		}
-	}
-}
-
-bool ChessBoard::isVulnerable(int pos, int color) const
-{
-	int target_pos, target_figure, row, col, i,j, end;
-
-	// Determine row and column
-	row = pos / 8;
-	col = pos % 8;
-
-	// 1. Look for Rooks, Queens and Kings above
-	for(target_pos = pos + 8; target_pos < 64; target_pos += 8)
-	{
-		if((target_figure = this->square[target_pos]) != EMPTY)
-		{
-            if(IS_BLACK(target_figure) != IS_BLACK(color))
-			{
-				if((target_pos - pos) == 8)
-				{
-					if(FIGURE(target_figure) == KING)
-						return true;
-				}
-
-				if((FIGURE(target_figure) == ROOK) || (FIGURE(target_figure) == QUEEN))
-					return true;
-			}
-
-			break;
-		}
-	}
-
-	// 2. Look for Rooks, Queens and Kings below
-	for(target_pos = pos - 8; target_pos >= 0; target_pos -= 8)
-	{
-		if((target_figure = this->square[target_pos]) != EMPTY)
-		{
-            if(IS_BLACK(target_figure) != IS_BLACK(color))
-			{
-				if((pos - target_pos) == 8)
-				{
-					if(FIGURE(target_figure) == KING)
-						return true;
-				}
-
-				if((FIGURE(target_figure) == ROOK) || (FIGURE(target_figure) == QUEEN))
-					return true;
-			}
-
-			break;
-		}
-	}
-
-	// 3. Look for Rooks, Queens and Kings left
-	for(target_pos = pos - 1, end = pos - (pos % 8); target_pos >= end; target_pos--)
-	{
-		if((target_figure = this->square[target_pos]) != EMPTY)
-		{
-            if(IS_BLACK(color) != IS_BLACK(target_figure))
-			{
-				if((pos - target_pos) == 1)
-				{
-					if(FIGURE(target_figure) == KING)
-						return true;
-				}
-
-				if((FIGURE(target_figure) == ROOK) || (FIGURE(target_figure) == QUEEN))
-					return true;
-			}
-
-			break;
-		}
-	}
-
-	// 4. Look for Rooks, Queens and Kings right
-	for(target_pos = pos + 1, end = pos + (8 - pos % 8); target_pos < end; target_pos++)
-	{
-		if((target_figure = this->square[target_pos]) != EMPTY)
-		{
-            if(IS_BLACK(color) != IS_BLACK(target_figure))
-			{
-				if((target_pos - pos) == 1)
-				{
-					if(FIGURE(target_figure) == KING)
-						return true;
-				}
-
-				if((FIGURE(target_figure) == ROOK) || (FIGURE(target_figure) == QUEEN))
-					return true;
-			}
-
-			break;
-		}
-	}
-
-	// 5. Look for Bishops, Queens, Kings and Pawns north-east
-	for(i = row + 1, j = col + 1; (i < 8) && (j < 8); i++, j++)
-	{
-		target_pos = i * 8 + j;
-		if((target_figure = this->square[target_pos]) != EMPTY)
-		{
-            if(IS_BLACK(color) != IS_BLACK(target_figure))
-			{
-				if((target_pos - pos) == 9)
-				{
-					if(FIGURE(target_figure) == KING)
-						return true;
-                    else if(!IS_BLACK(color) && (FIGURE(target_figure) == PAWN))
-						return true;
-				}
-
-				if((FIGURE(target_figure) == BISHOP) || (FIGURE(target_figure) == QUEEN))
-					return true;
-			}
-
-			break;
-		}
-	}
-	
-	// 6. Look for Bishops, Queens, Kings and Pawns south-east
-	for(i = row - 1, j = col + 1; (i >= 0) && (j < 8); i--, j++)
-	{
-		target_pos = i * 8 + j;
-		if((target_figure = this->square[target_pos]) != EMPTY)
-		{
-            if(IS_BLACK(color) != IS_BLACK(target_figure))
-			{
-				if((pos - target_pos) == 7)
-				{
-					if(FIGURE(target_figure) == KING)
-						return true;
-                    else if(IS_BLACK(color) && (FIGURE(target_figure) == PAWN))
-						return true;
-				}
-
-				if((FIGURE(target_figure) == BISHOP) || (FIGURE(target_figure) == QUEEN))
-					return true;
-			}
-
-			break;
-		}
-	}
-
-	// 7. Look for Bishops, Queens, Kings and Pawns south-west
-	for(i = row - 1, j = col - 1; (i >= 0) && (j >= 0); i--, j--)
-	{
-		target_pos = i * 8 + j;
-		if((target_figure = this->square[target_pos]) != EMPTY)
-		{
-            if(IS_BLACK(color) != IS_BLACK(target_figure))
-			{
-				if((pos - target_pos) == 9)
-				{
-					if(FIGURE(target_figure) == KING)
-						return true;
-                    else if(IS_BLACK(color) && (FIGURE(target_figure) == PAWN))
-						return true;
-				}
-
-				if((FIGURE(target_figure) == BISHOP) || (FIGURE(target_figure) == QUEEN))
-					return true;
-			}
-
-			break;
-		}
-	}
-
-	// 8. Look for Bishops, Queens, Kings and Pawns north-west
-	for(i = row + 1, j = col - 1; (i < 8) && (j >= 0); i++, j--)
-	{
-		target_pos = i * 8 + j;
-		if((target_figure = this->square[target_pos]) != EMPTY)
-		{
-            if(IS_BLACK(color) != IS_BLACK(target_figure))
-			{
-				if((target_pos - pos) == 7)
-				{
-					if(FIGURE(target_figure) == KING)
-						return true;
-                    else if(!IS_BLACK(color) && (FIGURE(target_figure) == PAWN))
-						return true;
-				}
-
-				if((FIGURE(target_figure) == BISHOP) || (FIGURE(target_figure) == QUEEN))
-					return true;
-			}
-
-			break;
-		}
-	}
-	
-	// 9. Look for Knights in upper positions
-	if(row < 6)
-	{
-		// right
-		if(col < 7)
-		{
-			target_pos = pos + 17;
-
-			if((target_figure = this->square[target_pos]) != EMPTY)
-			{
-                if(IS_BLACK(color) != IS_BLACK(target_figure))
-				{
-					if(FIGURE(target_figure) == KNIGHT) return true;
-				}
-			}
-		}
-		
-		// left
-		if(col > 0)
-		{
-			target_pos = pos + 15;
-		
-			if((target_figure = this->square[target_pos]) != EMPTY)
-			{
-                if(IS_BLACK(color) != IS_BLACK(target_figure))
-				{
-					if(FIGURE(target_figure) == KNIGHT) return true;
-				}
-			}		
-		}
-	}
-	
-	// 10. Look for Knights in lower positions
-	if(row > 1)
-	{
-		// right
-		if(col < 7)
-		{
-			target_pos = pos - 15;
-		
-			if((target_figure = this->square[target_pos]) != EMPTY)
-			{
-                if(IS_BLACK(color) != IS_BLACK(target_figure))
-				{
-					if(FIGURE(target_figure) == KNIGHT) return true;
-				}
-			}
-		}
-		
-		// left
-		if(col > 0)
-		{
-			target_pos = pos - 17;
-		
-			if((target_figure = this->square[target_pos]) != EMPTY)
-			{
-                if(IS_BLACK(color) != IS_BLACK(target_figure))
-				{
-					if(FIGURE(target_figure) == KNIGHT) return true;
-				}
-			}		
-		}
-	}
-
-	// 11. Look for Knights in right positions
-	if(col < 6)
-	{
-		// up
-		if(row < 7)
-		{
-			target_pos = pos + 10;
-		
-			if((target_figure = this->square[target_pos]) != EMPTY)
-			{
-                if(IS_BLACK(color) != IS_BLACK(target_figure))
-				{
-					if(FIGURE(target_figure) == KNIGHT) return true;
-				}
-			}
-		}
-		
-		// down
-		if(row > 0)
-		{
-			target_pos = pos - 6;
-		
-			if((target_figure = this->square[target_pos]) != EMPTY)
-			{
-                if(IS_BLACK(color) != IS_BLACK(target_figure))
-				{
-					if(FIGURE(target_figure) == KNIGHT) return true;
-				}
-			}		
-		}
-	}
-
-	// 12. Look for Knights in left positions
-	if(col > 1)
-	{
-		// up
-		if(row < 7)
-		{
-			target_pos = pos + 6;
-		
-			if((target_figure = this->square[target_pos]) != EMPTY)
-			{
-                if(IS_BLACK(color) != IS_BLACK(target_figure))
-				{
-					if(FIGURE(target_figure) == KNIGHT) return true;
-				}
-			}
-		}
-		
-		// down
-		if(row > 0)
-		{
-			target_pos = pos - 10;
-		
-			if((target_figure = this->square[target_pos]) != EMPTY)
-			{
-                if(IS_BLACK(color) != IS_BLACK(target_figure))
-				{
-					if(FIGURE(target_figure) == KNIGHT) return true;
-				}
-			}		
-		}
-	}	
-
-	return false;
-}
-
-bool ChessBoard::isValidMove(int color, const Move & move) const
-{
-	bool valid = false;
-    list<Move> regulars;
-
-    ChessBoard * board_ptr = const_cast<ChessBoard *>(this);
-
-    MoveGenerator<false>::getMoves(*board_ptr, color, regulars, regulars);
-
-	for(list<Move>::iterator it = regulars.begin(); it != regulars.end() && !valid; ++it)
-	{
-		if(move.from == (*it).from && move.to == (*it).to)
-		{
-            // const_cast is made really for debugging
-            // this garanties that our move is same as one of generated
-            const_cast<Move&>(move) = *it;
-
-            board_ptr->move(move);
-			if(!isVulnerable(color ? black_king_pos : white_king_pos, color))
-				valid = true;
-            board_ptr->undoMove(*it);
-		}
-	}
-
-	return valid;
-}
-
-ChessPlayer::Status ChessBoard::getPlayerStatus(int color)
-{
-    if (non_pawn_kick_moves_count >= 50) {
-        return ChessPlayer::Draw;
-    }
-	bool king_vulnerable = false, can_move = false;
-    list<Move> regulars;
-
-    MoveGenerator<false>::getMoves(*this, color, regulars, regulars);
-
-	if(isVulnerable(color ? black_king_pos : white_king_pos, color))
-		king_vulnerable = true;
-
-	for(list<Move>::iterator it = regulars.begin(); it != regulars.end() && !can_move; ++it)
-	{
-		this->move(*it);
-		if(!isVulnerable(color ? black_king_pos : white_king_pos, color))
-		{
-			can_move = true;
-		}
-		undoMove(*it);
-	}
+	bool king_vulnerable = isVulnerable(color ? black_king_pos : white_king_pos, color);
+	bool can_move = NOT regulars.empty();
 
 	if(king_vulnerable && can_move)
 		return ChessPlayer::InCheck;
 	if(king_vulnerable && !can_move)
 		return ChessPlayer::Checkmate;
-    if((!king_vulnerable && !can_move) || non_pawn_kick_moves_count >= 50)
+    if(!can_move)
 		return ChessPlayer::Stalemate;
 
 	return ChessPlayer::Normal;
@@ -1700,11 +1113,7 @@ ChessPlayer::Status ChessBoard::getPlayerStatus(int color)
 void ChessBoard::move(const Move & move)
 {
 #ifdef TRACE
-    static int move_counter = 0;
-    move_counter++;
-    stringstream str;
-    str << "Move counter: " << move_counter;
-    Global::instance().log(str.str());
+    Global::instance().log("Move: " + move.toString());
 #endif
 //    int count = get_all_figures_count();
 //    refreshFigures();
@@ -1712,9 +1121,15 @@ void ChessBoard::move(const Move & move)
 //        cout << "";
 //        assert(false);
 //    }
+    undo_stack.push_back({passant_pos, non_pawn_kick_moves_count, hash});
+
+    bool castling_squares = (BIT(move.from) | BIT(move.to)) & CASTLING_SQUARES;
+    int castling_rights = castling_squares ? castlingRights() : 0;
+
     if (passant_pos != -1) {
         //remove old passant flag from opponents PAWN
         square[passant_pos] = CLEAR_PASSANT(square[passant_pos]);
+        hash ^= zobrist.passant[passant_pos % 8];
         passant_pos = -1;
     }
     if (move.capture || (FIGURE(move.figure) == PAWN)) {
@@ -1732,8 +1147,8 @@ void ChessBoard::move(const Move & move)
             movePawn(move);
             break;
 		default:
-            this->square[static_cast<int>(move.from)] = EMPTY;
-            this->square[static_cast<int>(move.to)] = SET_MOVED(move.figure);
+            setFigure(move.from, EMPTY);
+            setFigure(move.to, SET_MOVED(move.figure));
 			break;
 	}
     if (move.capture) {
@@ -1742,6 +1157,9 @@ void ChessBoard::move(const Move & move)
     if (move.to != move.from) {
         toogleColor();
     }
+    if (castling_squares) {
+        hash ^= zobrist.castling[castling_rights] ^ zobrist.castling[castlingRights()];
+    }
 
 //    count = get_all_figures_count();
 //    refreshFigures();
@@ -1750,12 +1168,6 @@ void ChessBoard::move(const Move & move)
 //        cout << "";
 //        assert(false);
 //    }
-        if (IS_PASSANT(square[D4]) && IS_BLACK(square[D4])
-         ) {
-            print(move);
-            assert(false);
-        }
-
 //    if (IS_PASSANT(square[F7]) && IS_BLACK(square[F7])
 //     || IS_PASSANT(square[F6]) && IS_BLACK(square[F6])
 //     || IS_PASSANT(square[F4]) && IS_BLACK(square[F4])
@@ -1765,9 +1177,71 @@ void ChessBoard::move(const Move & move)
 //    }
 }
 
+bool ChessBoard::isRepetition(int times) const
+{
+    // undo_stack keeps the key of every position before the current one,
+    // the same side was to move an even number of plies back, and it takes
+    // both sides two moves to come back
+    int size = undo_stack.size();
+    int reversible = min(non_pawn_kick_moves_count, size);
+    for (int back = 4; back <= reversible; back += 2) {
+        if (undo_stack[size - back].hash == hash && --times == 0)
+            return true;
+    }
+    return false;
+}
+
+void ChessBoard::makeNullMove()
+{
+    undo_stack.push_back({passant_pos, non_pawn_kick_moves_count, hash});
+    if (passant_pos != -1) {
+        square[passant_pos] = CLEAR_PASSANT(square[passant_pos]);
+        hash ^= zobrist.passant[passant_pos % 8];
+        passant_pos = -1;
+    }
+    non_pawn_kick_moves_count = 0;
+    toogleColor();
+}
+
+void ChessBoard::undoNullMove()
+{
+    const IrreversibleState & state = undo_stack.back();
+    non_pawn_kick_moves_count = state.non_pawn_kick_moves_count;
+    next_move_color = TOGGLE_COLOR(next_move_color);
+    if (state.passant_pos != -1) {
+        square[state.passant_pos] = SET_PASSANT(square[state.passant_pos]);
+    }
+    passant_pos = state.passant_pos;
+    hash = state.hash;
+    undo_stack.pop_back();
+}
+
+bool ChessBoard::givesCheck(const Move & move) const
+{
+    int king_pos = IS_BLACK(move.figure) ? white_king_pos : black_king_pos;
+    TBitBoard occupied = (occupied_bb ^ BIT(move.from)) | BIT(move.to);
+
+    // sliders behind the figure which moves away
+    if (attackers(king_pos, OPPOSITE(move.figure), occupied) & ~BIT(move.from))
+        return true;
+
+    TBitBoard attacks = 0;
+    switch (move.promotion ? move.promotion : FIGURE(move.figure)) {
+        case PAWN:   attacks = pawn_attacks[COLOR_INDEX(move.figure)][move.to]; break;
+        case KNIGHT: attacks = knight_attacks[move.to]; break;
+        case BISHOP: attacks = bishopAttacks(move.to, occupied); break;
+        case ROOK:   attacks = rookAttacks(move.to, occupied); break;
+        case QUEEN:  attacks = queenAttacks(move.to, occupied); break;
+        default: break;
+    }
+    return attacks & BIT(king_pos);
+}
+
 void ChessBoard::undoMove(const Move & move)
 {
-    non_pawn_kick_moves_count = move.non_pawn_kick_moves_count_opponent;
+    const IrreversibleState & state = undo_stack.back();
+    non_pawn_kick_moves_count = state.non_pawn_kick_moves_count;
+
 	// kings and pawns receive special treatment
 	switch(FIGURE(move.figure))
 	{
@@ -1780,8 +1254,8 @@ void ChessBoard::undoMove(const Move & move)
 				break;
 			}
 		default:
-            this->square[static_cast<int>(move.from)] = move.figure;
-            this->square[static_cast<int>(move.to)] = move.capture;
+            setFigure(move.from, move.figure);
+            setFigure(move.to, move.capture);
 			break;
 	}
     if (move.capture) {
@@ -1791,10 +1265,14 @@ void ChessBoard::undoMove(const Move & move)
         toogleColor();
     }
 
-    if (move.passant_pos_opponent != -1) {
-        square[move.passant_pos_opponent] = SET_PASSANT(square[move.passant_pos_opponent]);
+    if (state.passant_pos != -1) {
+        square[state.passant_pos] = SET_PASSANT(square[state.passant_pos]);
     }
-    this->passant_pos = move.passant_pos_opponent;
+    this->passant_pos = state.passant_pos;
+
+    // cheaper than reverting castling and passant keys one by one
+    hash = state.hash;
+    undo_stack.pop_back();
 
 //    int count = get_all_figures_count();
 //    refreshFigures();
@@ -1824,35 +1302,37 @@ void ChessBoard::movePawn(const Move & move)
 		{
 			capture_field = move.to + 8;
 			if((move.from / 8) == 3)
-				this->square[capture_field] = EMPTY;
+				setFigure(capture_field, EMPTY);
 		}
 		else
 		{
 			capture_field = move.to - 8;
 			if((move.from / 8) == 4)
-				this->square[capture_field] = EMPTY;
+				setFigure(capture_field, EMPTY);
 		}
 	}
 
-    this->square[static_cast<int>(move.from)] = EMPTY;
+    setFigure(move.from, EMPTY);
 
-	// mind pawn promotion
+	// mind pawn promotion, queen unless told otherwise
+    int promotion = move.promotion != EMPTY ? move.promotion : QUEEN;
 	if(IS_BLACK(move.figure)) {
 		if(move.to / 8 == 0)
-            this->square[static_cast<int>(move.to)] = SET_MOVED(SET_BLACK(QUEEN));
+            setFigure(move.to, SET_MOVED(SET_BLACK(promotion)));
 		else
-            this->square[static_cast<int>(move.to)] = SET_MOVED(move.figure);
+            setFigure(move.to, SET_MOVED(move.figure));
 	}
 	else {
 		if(move.to / 8 == 7)
-            this->square[static_cast<int>(move.to)] = SET_MOVED(QUEEN);
+            setFigure(move.to, SET_MOVED(promotion));
 		else
-            this->square[static_cast<int>(move.to)] = SET_MOVED(move.figure);
+            setFigure(move.to, SET_MOVED(move.figure));
     }
 
     if (abs(move.to - move.from) == 16) {
         passant_pos = move.to;
         square[move.to] = SET_PASSANT(square[move.to]);
+        hash ^= zobrist.passant[move.to % 8];
     }
 }
 
@@ -1860,7 +1340,7 @@ void ChessBoard::undoMovePawn(const Move & move)
 {
 	int capture_field;
 
-    this->square[static_cast<int>(move.from)] = CLEAR_PASSANT(move.figure);
+    setFigure(move.from, CLEAR_PASSANT(move.figure));
 
 	// check for en-passant capture
 	if(IS_PASSANT(move.capture))
@@ -1869,28 +1349,28 @@ void ChessBoard::undoMovePawn(const Move & move)
 		{
 			capture_field = move.to + 8;
 			if(move.from / 8 == 3) {
-				this->square[capture_field] = move.capture;
-                this->square[static_cast<int>(move.to)] = EMPTY;
+				setFigure(capture_field, move.capture);
+                setFigure(move.to, EMPTY);
 			}
 			else {
-                this->square[static_cast<int>(move.to)] = move.capture;
+                setFigure(move.to, move.capture);
 			}
 		}
 		else
 		{
 			capture_field = move.to - 8;
 			if(move.from / 8 == 4) {
-				this->square[capture_field] = move.capture;
-                this->square[static_cast<int>(move.to)] = EMPTY;
+				setFigure(capture_field, move.capture);
+                setFigure(move.to, EMPTY);
 			}
 			else {
-                this->square[static_cast<int>(move.to)] = move.capture;
+                setFigure(move.to, move.capture);
 			}
 		}
 	}
 	else
 	{
-        this->square[static_cast<int>(move.to)] = move.capture;
+        setFigure(move.to, move.capture);
 	}
 }
 
@@ -1902,20 +1382,20 @@ void ChessBoard::moveKing(const Move & move)
 		switch(move.to)
 		{
 			case G1:
-				this->square[H1] = EMPTY;
-				this->square[F1] = SET_MOVED(ROOK);
+				setFigure(H1, EMPTY);
+				setFigure(F1, SET_MOVED(ROOK));
 				break;
 			case G8:
-				this->square[H8] = EMPTY;
-				this->square[F8] = SET_MOVED(SET_BLACK(ROOK));
+				setFigure(H8, EMPTY);
+				setFigure(F8, SET_MOVED(SET_BLACK(ROOK)));
 				break;
 			case C1:
-				this->square[A1] = EMPTY;
-				this->square[D1] = SET_MOVED(ROOK);
+				setFigure(A1, EMPTY);
+				setFigure(D1, SET_MOVED(ROOK));
 				break;
 			case C8:
-				this->square[A8] = EMPTY;
-				this->square[D8] = SET_MOVED(SET_BLACK(ROOK));
+				setFigure(A8, EMPTY);
+				setFigure(D8, SET_MOVED(SET_BLACK(ROOK)));
 				break;
 			default:
 				break;
@@ -1923,8 +1403,8 @@ void ChessBoard::moveKing(const Move & move)
 	}
 
 	// regular move
-    this->square[static_cast<int>(move.from)] = EMPTY;
-    this->square[static_cast<int>(move.to)] = SET_MOVED(move.figure);
+    setFigure(move.from, EMPTY);
+    setFigure(move.to, SET_MOVED(move.figure));
 	
 	// update king position variable
 	if(IS_BLACK(move.figure)) {
@@ -1945,20 +1425,20 @@ void ChessBoard::undoMoveKing(const Move & move)
 		switch(move.to)
 		{
 			case G1:
-				this->square[H1] = ROOK;
-				this->square[F1] = EMPTY;
+				setFigure(H1, ROOK);
+				setFigure(F1, EMPTY);
 				break;
 			case G8:
-				this->square[H8] = SET_BLACK(ROOK);
-				this->square[F8] = EMPTY;
+				setFigure(H8, SET_BLACK(ROOK));
+				setFigure(F8, EMPTY);
 				break;
 			case C1:
-				this->square[A1] = ROOK;
-				this->square[D1] = EMPTY;
+				setFigure(A1, ROOK);
+				setFigure(D1, EMPTY);
 				break;
 			case C8:
-				this->square[A8] = SET_BLACK(ROOK);
-				this->square[D8] = EMPTY;
+				setFigure(A8, SET_BLACK(ROOK));
+				setFigure(D8, EMPTY);
 				break;
 			default:
 				break;
@@ -1966,8 +1446,8 @@ void ChessBoard::undoMoveKing(const Move & move)
 	}
 
 	// regular undo
-    this->square[static_cast<int>(move.from)] = move.figure;
-    this->square[static_cast<int>(move.to)] = move.capture;
+    setFigure(move.from, move.figure);
+    setFigure(move.to, move.capture);
 
 	// update king position variable
 	if(IS_BLACK(move.figure)) {
@@ -1981,7 +1461,7 @@ void ChessBoard::undoMoveKing(const Move & move)
 void HelperFunction() {
     ChessBoard board;
     int color;
-    list<Move> moves;
+    MoveList moves;
 
     MoveGenerator<false>::getMoves(board, color, moves, moves);
     MoveGenerator<true>::getMoves(board, color, moves, moves);
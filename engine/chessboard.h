@@ -2,10 +2,12 @@
 
 #include "chessplayer.h"
 #include <string>
-#include <list>
+#include <vector>
 #include <boost/optional.hpp>
 
 #include "global.h"
+#include "bitboard.h"
+#include "zobrist.h"
 
 // Pieces defined in lower 4 bits
 #define EMPTY	0x00	// Empty square
@@ -24,6 +26,8 @@
 #define IS_BLACK(x)  (0x10 & x)
 #define IS_WHITE(x)  (!IS_BLACK(x))
 #define OPPOSITE(x)  (0x10 ^ x)
+// Index into per-color arrays: 0 for white, 1 for black
+#define COLOR_INDEX(x) (IS_BLACK(x) >> 4)
 
 
 #define SET_MOVED(x)  (x | 0x20)
@@ -50,33 +54,82 @@ struct Move
 
     std::string toString(void) const;
     static boost::optional<Move> fromString(const ChessBoard & board, const std::string & str);
+
+    /*
+    * 16 bit form keeping only from, to and promotion, e.g. for hash tables.
+    * fromPacked() restores the rest of the move from the board it was
+    * generated for.
+    */
+    unsigned short packed() const {
+        return from | (to << 6) | (promotion << 12);
+    }
+    static Move fromPacked(const ChessBoard & board, unsigned short packed);
 	
 	/*
 	* True if moves are equal.
 	*/
 	bool operator==(const Move & b) const;
 
+    // board is seen one-dimensional
+    unsigned short from : 6;
+    unsigned short to : 6;
+    unsigned short promotion : 4; // figure a pawn turns into, EMPTY otherwise
+
     char figure;	// figure which is moved
-	char from, to;	// board is seen one-dimensional
     char capture;	// piece that resides at destination square
-
-    /**
-     * @brief passant_pos_opponent is a position of the opponent's
-     * passant pawn position durign the move
-     */
-    signed short passant_pos_opponent = -1;
-
-    int non_pawn_kick_moves_count_opponent = 0;
 };
+static_assert(sizeof(Move) == 4, "Move is expected to be packed into 32 bits");
+
 typedef boost::optional<Move> TMoveOpt;
 static const Move EMPTY_MOVE = 
 {
-    .figure = 0, 
     .from = 0, 
     .to = 0, 
-    .capture = 0, 
-    .passant_pos_opponent = -1, 
-    .non_pawn_kick_moves_count_opponent = 0
+    .promotion = EMPTY, 
+    .figure = 0, 
+    .capture = 0
+};
+
+/*
+* Fixed-capacity move buffer, meant to live on the stack. No legal chess
+* position has more than 218 moves, so push_back never checks the bound.
+*/
+class MoveList
+{
+public:
+    static const int CAPACITY = 256;
+
+    typedef Move value_type;
+    typedef Move * iterator;
+    typedef const Move * const_iterator;
+
+    void push_back(const Move & move) {
+        moves[count++] = move;
+    }
+    void pop_back() {
+        count--;
+    }
+    void clear() {
+        count = 0;
+    }
+    int size() const {
+        return count;
+    }
+    bool empty() const {
+        return count == 0;
+    }
+
+    Move & operator[](int index) { return moves[index]; }
+    const Move & operator[](int index) const { return moves[index]; }
+
+    iterator begin() { return moves; }
+    iterator end() { return moves + count; }
+    const_iterator begin() const { return moves; }
+    const_iterator end() const { return moves + count; }
+
+private:
+    int count = 0;
+    Move moves[CAPACITY];
 };
 
 enum Position {
@@ -94,6 +147,14 @@ enum Position {
 class ChessBoard
 {
 public:
+    // Castling rights mask, see castlingRights()
+    enum Castling {
+        WHITE_SHORT = 0x01,
+        WHITE_LONG  = 0x02,
+        BLACK_SHORT = 0x04,
+        BLACK_LONG  = 0x08
+    };
+
 	ChessBoard();
 
     /*
@@ -123,15 +184,35 @@ public:
 	void initDefaultSetup(void);
 
     /*
-    * Updates internal figures count
+    * Updates internal figures count, kings positions and bitboards from
+    * the square array
     */
     void refreshFigures();
 
+    /*
+    * Places figure (or EMPTY) on the square and keeps bitboards in sync.
+    * Flag-only changes (moved, passant) may be written to square directly.
+    */
+    void setFigure(int pos, char figure);
+
 
     void toogleColor() {
         next_move_color = TOGGLE_COLOR(next_move_color);
+        hash ^= zobrist.black_to_move;
     }
 
+    /*
+    * Castlings still available as a mask of Castling values. Derived from
+    * unmoved kings and rooks in their initial squares.
+    */
+    int castlingRights() const;
+
+    /*
+    * Zobrist key of the position computed from scratch, the figures are
+    * found through occupied_bb. Normally the key is kept up to date in hash.
+    */
+    uint64_t computeHash() const;
+
 
 	/*
 	* Returns true, if the square given by pos is vulnerable to the opponent.
@@ -140,26 +221,77 @@ public:
 	*/
 	bool isVulnerable(int pos, int color) const;
 
+    /*
+    * Opponent figures of color which attack the square if the squares of
+    * occupied are taken. Pawns and knights are not blocked, so the result
+    * may contain a figure that occupied does not have any more.
+    */
+    TBitBoard attackers(int pos, int color, TBitBoard occupied) const;
+
+    /*
+    * Figures of both colors among occupied which attack the square, with
+    * sliders blocked by occupied
+    */
+    TBitBoard attackersTo(int pos, TBitBoard occupied) const;
+
+    /*
+    * Static exchange evaluation: the material the side making the capture
+    * wins (or loses, if negative) when both sides keep recapturing on the
+    * target square with their least valuable figure, each free to stop.
+    * Sliders lined up behind each other join in. Pins are not looked at.
+    */
+    int staticExchange(const Move & move) const;
+
+    /*
+    * Own figures of color which are the only ones between their king and
+    * an opponent slider, they may only move along that line
+    */
+    TBitBoard pinned(int color) const;
+
 	/*
 	* True if move is a valid move for player of given color. Please note, that
 	* a move that puts the player's own king in check, is also treated as
-	* invalid.
+	* invalid. Only the moves of the figure on the from square are generated.
+	* A valid move is completed with the generated one (moved figure,
+	* capture), so only from, to and promotion have to be set.
 	*/
-    bool isValidMove(int color, const Move &move) const ;
+    bool isValidMove(int color, Move &move) const ;
 
 	/*
-	* Returns the status of player of given color. This method is not declared
-	* const, because it needs to simulate moves on the board to draw a
-	* conclusion.
+	* Returns the status of player of given color. A draw by the 50 moves
+	* rule or by threefold repetition comes before anything else.
 	*/
-	ChessPlayer::Status getPlayerStatus(int color);
+	ChessPlayer::Status getPlayerStatus(int color) const;
 
 	/*
-	* Move and undo moves
+	* Move and undo moves. Moves have to be undone in reverse order, the
+	* state a move cannot restore by itself is kept on undo_stack.
 	*/
 	void move(const Move & move);
 	void undoMove(const Move & move);
 
+    /*
+    * True if the position occurred the given number of times before with
+    * the same side to move. Only the positions since the last capture or
+    * pawn move (or null move) are looked at, none before can be the same.
+    */
+    bool isRepetition(int times = 1) const;
+
+    /*
+    * Passes the move to the opponent (for null-move pruning). Undone by
+    * undoNullMove(), in order with the other moves. No repetition reaches
+    * back across it.
+    */
+    void makeNullMove();
+    void undoNullMove();
+
+    /*
+    * True if the move checks the opponent, directly or by uncovering a
+    * slider. The rook of a castling and en passant captures uncovering a
+    * line are not looked at.
+    */
+    bool givesCheck(const Move & move) const;
+
 	void movePawn(const Move & move);
 	void undoMovePawn(const Move & move);
 
@@ -179,9 +311,22 @@ public:
         return figures_count[0] + figures_count[1];
     }
 
+    TBitBoard pieces(int color, int figure) const {
+        return figures_bb[COLOR_INDEX(color)][figure];
+    }
+    TBitBoard pieces(int color) const {
+        return color_bb[COLOR_INDEX(color)];
+    }
+
 	// THE BOARD ITSELF
 	char square[8*8];
 
+    // same position as sets of squares: [color index][figure type],
+    // per color and all figures together
+    TBitBoard figures_bb[2][7] = {};
+    TBitBoard color_bb[2] = {0, 0};
+    TBitBoard occupied_bb = 0;
+
 	// to keep track of the kings
 	char black_king_pos;
 	char white_king_pos;
@@ -195,51 +340,89 @@ public:
 
     signed short passant_pos = -1;
 
+    // Zobrist key of the position, updated with every move
+    uint64_t hash = 0;
+
+    // Sum of the piece-square values of all figures (white minus black) in
+    // the middlegame and in the endgame, updated with every move
+    int psq_score[2] = {0, 0};
+
+    // Zobrist key of the pawns alone, the key of the pawn structure table
+    uint64_t pawn_hash = 0;
+
+    /*
+    * State before each move made on this board, one entry per ply
+    */
+    struct IrreversibleState {
+        signed short passant_pos;
+        int non_pawn_kick_moves_count;
+        uint64_t hash;
+    };
+    std::vector<IrreversibleState> undo_stack;
 };
+/*
+* Legal move generation: pinned figures only move along their pin line,
+* in check only the checker is captured or the check blocked (or the king
+* moves away), the king never steps on an attacked square. No move has to
+* be made to find out whether it leaves the own king in check.
+*/
 template<bool capture_only>
 class MoveGenerator {
 public:
     /*
-    * Generates all moves for one side.
+    * Generates all legal moves for one side.
     */
-   static void getMoves(ChessBoard & board, int color, std::list<Move> & moves,
-        std::list<Move> & captures);
+   static void getMoves(const ChessBoard & board, int color, MoveList & moves,
+        MoveList & captures);
 
     /*
-    * All possible moves for a pawn piece.
+    * Legal moves of the figure on the square.
     */
-    static void getPawnMoves(ChessBoard & board, int figure, int pos, std::list<Move> & moves,
-        std::list<Move> & captures);
+    static void getFigureMoves(const ChessBoard & board, int pos, MoveList & moves,
+        MoveList & captures);
+
+    /*
+    * All possible moves for a pawn piece. allowed are the squares the
+    * figure may go to without leaving its king in check, en passant
+    * captures are checked on their own.
+    */
+    static void getPawnMoves(const ChessBoard & board, int figure, int pos, TBitBoard allowed,
+        MoveList & moves, MoveList & captures);
 
     /*
     * All possible moves for a rook piece.
     */
-    static void getRookMoves(ChessBoard & board, int figure, int pos, std::list<Move> & moves,
-        std::list<Move> & captures);
+    static void getRookMoves(const ChessBoard & board, int figure, int pos, TBitBoard allowed,
+        MoveList & moves, MoveList & captures);
 
     /*
     * All possible moves for a knight piece.
     */
-    static void getKnightMoves(ChessBoard & board, int figure, int pos, std::list<Move> & moves,
-        std::list<Move> & captures);
+    static void getKnightMoves(const ChessBoard & board, int figure, int pos, TBitBoard allowed,
+        MoveList & moves, MoveList & captures);
 
     /*
     * All possible moves for a bishop piece.
     */
-    static void getBishopMoves(ChessBoard & board, int figure, int pos, std::list<Move> & moves,
-        std::list<Move> & captures);
+    static void getBishopMoves(const ChessBoard & board, int figure, int pos, TBitBoard allowed,
+        MoveList & moves, MoveList & captures);
 
     /*
     * All possible moves for a queen piece.
     */
-    static void getQueenMoves(ChessBoard & board, int figure, int pos, std::list<Move> & moves,
-        std::list<Move> & captures);
+    static void getQueenMoves(const ChessBoard & board, int figure, int pos, TBitBoard allowed,
+        MoveList & moves, MoveList & captures);
 
     /*
-    * All possible moves for a king piece.
+    * All possible moves for a king piece, none to an attacked square.
     */
-    static void getKingMoves(ChessBoard & board, int figure, int pos, std::list<Move> & moves,
-        std::list<Move> & captures);
-};
-
+    static void getKingMoves(const ChessBoard & board, int figure, int pos, MoveList & moves,
+        MoveList & captures);
 
+private:
+    /*
+    * Moves of a figure other than the king, restricted to allowed
+    */
+    static void addFigureMoves(const ChessBoard & board, int figure, int pos, TBitBoard allowed,
+        MoveList & moves, MoveList & captures);
+};
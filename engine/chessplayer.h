@@ -6,6 +6,8 @@ struct Move;
 struct AdvancedMoveData
 {
     int board_evaluation = 0;
+    int depth = 0;                  // last finished search depth
+    unsigned long long nodes = 0;   // positions visited by the search
 };
 class Config;
 class ChessPlayer
@@ -0,0 +1,120 @@
+#include "compactposition.h"
+#include "evaluation.h"
+#include <algorithm>
+
+using namespace std;
+
+// Castling rights left after a move from or to the square
+static constexpr int castlingMask(int pos)
+{
+    return pos == E1 ? ~(ChessBoard::WHITE_SHORT | ChessBoard::WHITE_LONG) & 0x0F
+         : pos == H1 ? ~ChessBoard::WHITE_SHORT & 0x0F
+         : pos == A1 ? ~ChessBoard::WHITE_LONG & 0x0F
+         : pos == E8 ? ~(ChessBoard::BLACK_SHORT | ChessBoard::BLACK_LONG) & 0x0F
+         : pos == H8 ? ~ChessBoard::BLACK_SHORT & 0x0F
+         : pos == A8 ? ~ChessBoard::BLACK_LONG & 0x0F
+         : 0x0F;
+}
+
+CompactPosition CompactPosition::fromBoard(const ChessBoard & board)
+{
+    CompactPosition position;
+    for (int figure = 0; figure < 7; figure++)
+        position.figures_bb[figure] = board.figures_bb[0][figure] | board.figures_bb[1][figure];
+    position.color_bb[0] = board.color_bb[0];
+    position.color_bb[1] = board.color_bb[1];
+    position.hash = board.hash;
+    position.pawn_hash = board.pawn_hash;
+    position.psq_score[MIDGAME] = board.psq_score[MIDGAME];
+    position.psq_score[ENDGAME] = board.psq_score[ENDGAME];
+    position.king_pos[0] = board.white_king_pos;
+    position.king_pos[1] = board.black_king_pos;
+    position.passant_pos = board.passant_pos;
+    position.castling_rights = board.castlingRights();
+    position.non_pawn_kick_moves_count = min(board.non_pawn_kick_moves_count, 255);
+    position.next_move_color = board.next_move_color;
+    return position;
+}
+
+int CompactPosition::figureAt(int pos) const
+{
+    if (NOT (occupied() & BIT(pos)))
+        return EMPTY;
+    for (int figure = PAWN; figure <= KING; figure++) {
+        if (figures_bb[figure] & BIT(pos))
+            return figure;
+    }
+    return EMPTY;
+}
+
+void CompactPosition::addFigure(int color_index, int figure, int pos)
+{
+    figures_bb[figure] |= BIT(pos);
+    color_bb[color_index] |= BIT(pos);
+    hash ^= zobrist.figures[color_index][figure][pos];
+    if (figure == PAWN)
+        pawn_hash ^= zobrist.figures[color_index][PAWN][pos];
+    psq_score[MIDGAME] += piece_square.values[MIDGAME][color_index][figure][pos];
+    psq_score[ENDGAME] += piece_square.values[ENDGAME][color_index][figure][pos];
+}
+
+void CompactPosition::removeFigure(int color_index, int figure, int pos)
+{
+    figures_bb[figure] ^= BIT(pos);
+    color_bb[color_index] ^= BIT(pos);
+    hash ^= zobrist.figures[color_index][figure][pos];
+    if (figure == PAWN)
+        pawn_hash ^= zobrist.figures[color_index][PAWN][pos];
+    psq_score[MIDGAME] -= piece_square.values[MIDGAME][color_index][figure][pos];
+    psq_score[ENDGAME] -= piece_square.values[ENDGAME][color_index][figure][pos];
+}
+
+void CompactPosition::makeMove(const Move & move)
+{
+    int color_index = COLOR_INDEX(move.figure);
+    int figure = FIGURE(move.figure);
+
+    if (passant_pos != -1) {
+        hash ^= zobrist.passant[passant_pos % 8];
+        passant_pos = -1;
+    }
+    if (move.capture || figure == PAWN)
+        non_pawn_kick_moves_count = 0;
+    else if (non_pawn_kick_moves_count < 255)
+        non_pawn_kick_moves_count++;
+
+    if (move.capture) {
+        // en passant: the pawn taken has passed the target square
+        int captured_pos = move.to;
+        if (NOT (color_bb[1 - color_index] & BIT(move.to)))
+            captured_pos = color_index ? move.to + 8 : move.to - 8;
+        removeFigure(1 - color_index, FIGURE(move.capture), captured_pos);
+    }
+
+    removeFigure(color_index, figure, move.from);
+    if (figure == PAWN && (move.to / 8 == 0 || move.to / 8 == 7))
+        addFigure(color_index, move.promotion != EMPTY ? move.promotion : QUEEN, move.to);
+    else
+        addFigure(color_index, figure, move.to);
+
+    if (figure == KING) {
+        king_pos[color_index] = move.to;
+        // castling, the rook goes over to the other side of the king
+        if (abs(move.to - move.from) == 2) {
+            removeFigure(color_index, ROOK, move.to > move.from ? move.from + 3 : move.from - 4);
+            addFigure(color_index, ROOK, (move.from + move.to) / 2);
+        }
+    } else if (figure == PAWN && abs(move.to - move.from) == 16) {
+        passant_pos = move.to;
+        hash ^= zobrist.passant[move.to % 8];
+    }
+
+    int rights = castling_rights & castlingMask(move.from) & castlingMask(move.to);
+    if (rights != castling_rights) {
+        hash ^= zobrist.castling[castling_rights] ^ zobrist.castling[rights];
+        castling_rights = rights;
+    }
+
+    next_move_color = TOGGLE_COLOR(next_move_color);
+    hash ^= zobrist.black_to_move;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "chessboard.h"
+#include <type_traits>
+
+/*
+* A position and nothing else: no mailbox, no undo history, no pointers.
+* It is copied as a whole (copy-make): a child is the copy of its parent
+* with one move made on it, and taking the move back means dropping the
+* copy. So a position can be handed to another thread by value.
+*
+* The figures are only kept as sets of squares. The Zobrist key, the pawn
+* key and the piece-square scores are the same as those of a ChessBoard
+* in the same position.
+*/
+struct CompactPosition
+{
+    TBitBoard figures_bb[7];            // [figure type], both colors
+    TBitBoard color_bb[2];              // [color index]
+    uint64_t hash;
+    uint64_t pawn_hash;
+    int32_t psq_score[2];               // [phase], white minus black
+    int8_t king_pos[2];                 // [color index]
+    int8_t passant_pos;                 // pawn which has just moved two squares, -1 if none
+    uint8_t castling_rights;            // mask of ChessBoard::Castling values
+    uint8_t non_pawn_kick_moves_count;  // stops counting at 255
+    uint8_t next_move_color;            // WHITE or BLACK
+
+    static CompactPosition fromBoard(const ChessBoard & board);
+
+    /*
+    * Type of the figure on the square, EMPTY if there is none
+    */
+    int figureAt(int pos) const;
+
+    TBitBoard occupied() const {
+        return color_bb[0] | color_bb[1];
+    }
+
+    /*
+    * Makes a move generated by MoveGenerator for a board in this position
+    */
+    void makeMove(const Move & move);
+
+private:
+    void addFigure(int color_index, int figure, int pos);
+    void removeFigure(int color_index, int figure, int pos);
+};
+
+static_assert(std::is_trivially_copyable<CompactPosition>::value, "CompactPosition is copied with the bytes it is made of");
+static_assert(sizeof(CompactPosition) <= 128, "CompactPosition is expected to fit into two cache lines");
@@ -0,0 +1,69 @@
+#include "computepool.h"
+#include "pawntable.h"
+
+#include <algorithm>
+
+using namespace std;
+
+ComputePool::ComputePool(int threads_count, size_t player_hash_megabytes)
+ : queue(make_shared<Queue>()),
+   work(new boost::asio::io_service::work(queue->io)),
+   player_hash_megabytes(player_hash_megabytes),
+   pawn_table(make_shared<PawnTable>())
+{
+    for (int i = 0; i < max(threads_count, 1); i++) {
+        shared_ptr<Queue> thread_queue = queue;
+        threads.emplace_back([thread_queue]() {
+            thread_queue->io.run();
+        });
+    }
+}
+
+ComputePool::~ComputePool()
+{
+    work.reset();
+    queue->io.stop();
+    for (thread & worker : threads) {
+        // a thread cannot join itself, it ends on its own after the job
+        if (worker.get_id() == this_thread::get_id())
+            worker.detach();
+        else
+            worker.join();
+    }
+}
+
+void ComputePool::post(function<void()> job)
+{
+    queue->pending_jobs.fetch_add(1, memory_order_relaxed);
+    Queue * job_queue = queue.get();
+    queue->io.post([job_queue, job]() {
+        job();
+        job_queue->pending_jobs.fetch_sub(1, memory_order_relaxed);
+    });
+}
+
+int ComputePool::size() const
+{
+    return threads.size();
+}
+
+long long ComputePool::pending() const
+{
+    return queue->pending_jobs.load(memory_order_relaxed);
+}
+
+TTranspositionTablePtr ComputePool::newTranspositionTable() const
+{
+    return make_shared<TranspositionTable>(player_hash_megabytes);
+}
+
+TPawnTablePtr ComputePool::getPawnTable() const
+{
+    return pawn_table;
+}
+
+shared_ptr<ComputePool> ComputePool::shared()
+{
+    static shared_ptr<ComputePool> pool = make_shared<ComputePool>();
+    return pool;
+}
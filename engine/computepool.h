@@ -0,0 +1,73 @@
+#pragma once
+#include "aiplayer.h"
+
+#include <boost/asio/io_service.hpp>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/*
+* A fixed number of threads for the searches of many games, so that io
+* threads never search and the number of games is not bounded by threads.
+* Jobs wait in a queue till a thread is free.
+*
+* The pawn table belongs to the pool and is shared by all players
+* searching on it, its scores depend on the pawns alone. Transposition
+* tables are not shared: their scores depend on the history of the game
+* and their entries age with every search started on them, so each player
+* gets one of its own, of the size given to the constructor.
+*/
+class ComputePool
+{
+public:
+    // small enough for thousands of games
+    static const size_t DEFAULT_PLAYER_HASH_MB = 1;
+
+    explicit ComputePool(int threads = std::thread::hardware_concurrency(),
+                         size_t player_hash_megabytes = DEFAULT_PLAYER_HASH_MB);
+    ComputePool(const ComputePool &) = delete;
+    ComputePool& operator = (const ComputePool &) = delete;
+
+    /*
+    * Jobs still queued are dropped. May run on a thread of the pool, when
+    * a job lets go of the last reference to it.
+    */
+    ~ComputePool();
+
+    void post(std::function<void()> job);
+
+    int size() const;
+
+    /*
+    * Jobs posted and not finished yet, the running ones included
+    */
+    long long pending() const;
+
+    /*
+    * A new transposition table for one player
+    */
+    TTranspositionTablePtr newTranspositionTable() const;
+    TPawnTablePtr getPawnTable() const;
+
+    /*
+    * The pool of the process, one thread per core
+    */
+    static std::shared_ptr<ComputePool> shared();
+
+private:
+    // outlives the pool while a thread of it is still on its way out
+    struct Queue {
+        boost::asio::io_service io;
+        std::atomic<long long> pending_jobs{0};
+    };
+
+    std::shared_ptr<Queue> queue;
+    std::unique_ptr<boost::asio::io_service::work> work;
+    std::vector<std::thread> threads;
+
+    size_t player_hash_megabytes;
+    TPawnTablePtr pawn_table;
+};
+typedef std::shared_ptr<ComputePool> TComputePoolPtr;
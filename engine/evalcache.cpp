@@ -0,0 +1,33 @@
+#include "evalcache.h"
+
+using namespace std;
+
+EvalCache::EvalCache(size_t megabytes)
+ : slots(megabytes)
+{
+}
+
+void EvalCache::resize(size_t megabytes)
+{
+    slots.resize(megabytes);
+}
+
+void EvalCache::clear()
+{
+    slots.clear();
+}
+
+bool EvalCache::probe(uint64_t key, int & value) const
+{
+    uint64_t data;
+    if (!slots.probe(key, data))
+        return false;
+
+    value = static_cast<int32_t>(data);
+    return true;
+}
+
+void EvalCache::store(uint64_t key, int value)
+{
+    slots.store(key, static_cast<uint32_t>(value));
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "hashslots.h"
+
+/*
+* Static evaluations by the Zobrist key of the position (which includes the
+* side to move). The quiescent search evaluates the same positions over
+* and over again from different branches of the tree. Shared by all search
+* threads.
+*
+* A probe is a random memory access, it only pays off while evaluating
+* costs more than that (see AIPlayer::setEvalCacheSize).
+*/
+class EvalCache
+{
+public:
+    explicit EvalCache(size_t megabytes);
+    EvalCache(const EvalCache &) = delete;
+    EvalCache& operator = (const EvalCache &) = delete;
+
+    /*
+    * Reallocates the cache, all evaluations are lost
+    */
+    void resize(size_t megabytes);
+
+    void clear();
+
+    bool probe(uint64_t key, int & value) const;
+    void store(uint64_t key, int value);
+
+private:
+    HashSlots slots;
+};
@@ -0,0 +1,201 @@
+#include "evaluation.h"
+#include "chessboard.h"
+
+// Bonuses for a white figure, drawn as seen from white: the first row is
+// the eighth rank. Black figures use the same squares mirrored.
+static constexpr int pawn_bonus[2][64] = {
+    {
+         0,  0,  0,  0,  0,  0,  0,  0,
+        15, 15, 15, 15, 15, 15, 15, 15,
+         3,  3,  6,  9,  9,  6,  3,  3,
+         2,  2,  3,  8,  8,  3,  2,  2,
+         0,  0,  0,  6,  6,  0,  0,  0,
+         2, -2, -3,  0,  0, -3, -2,  2,
+         2,  3,  3, -6, -6,  3,  3,  2,
+         0,  0,  0,  0,  0,  0,  0,  0,
+    }, {
+         0,  0,  0,  0,  0,  0,  0,  0,
+        25, 25, 25, 25, 25, 25, 25, 25,
+        15, 15, 15, 15, 15, 15, 15, 15,
+         8,  8,  8,  8,  8,  8,  8,  8,
+         4,  4,  4,  4,  4,  4,  4,  4,
+         1,  1,  1,  1,  1,  1,  1,  1,
+         0,  0,  0,  0,  0,  0,  0,  0,
+         0,  0,  0,  0,  0,  0,  0,  0,
+    }
+};
+
+static constexpr int rook_bonus[64] = {
+     0,  0,  0,  0,  0,  0,  0,  0,
+     2,  3,  3,  3,  3,  3,  3,  2,
+    -2,  0,  0,  0,  0,  0,  0, -2,
+    -2,  0,  0,  0,  0,  0,  0, -2,
+    -2,  0,  0,  0,  0,  0,  0, -2,
+    -2,  0,  0,  0,  0,  0,  0, -2,
+    -2,  0,  0,  0,  0,  0,  0, -2,
+     0,  0,  0,  2,  2,  0,  0,  0,
+};
+
+static constexpr int knight_bonus[64] = {
+   -15,-10, -8, -8, -8, -8,-10,-15,
+   -10, -5,  0,  1,  1,  0, -5,-10,
+    -8,  1,  3,  4,  4,  3,  1, -8,
+    -8,  1,  4,  5,  5,  4,  1, -8,
+    -8,  0,  4,  5,  5,  4,  0, -8,
+    -8,  1,  3,  4,  4,  3,  1, -8,
+   -10, -5,  0,  1,  1,  0, -5,-10,
+   -15,-10, -8, -8, -8, -8,-10,-15,
+};
+
+static constexpr int bishop_bonus[64] = {
+    -7, -3, -3, -3, -3, -3, -3, -7,
+    -3,  0,  0,  0,  0,  0,  0, -3,
+    -3,  0,  2,  3,  3,  2,  0, -3,
+    -3,  2,  2,  3,  3,  2,  2, -3,
+    -3,  0,  3,  3,  3,  3,  0, -3,
+    -3,  3,  3,  3,  3,  3,  3, -3,
+    -3,  2,  0,  0,  0,  0,  2, -3,
+    -7, -3, -3, -3, -3, -3, -3, -7,
+};
+
+static constexpr int queen_bonus[64] = {
+    -7, -3, -3, -2, -2, -3, -3, -7,
+    -3,  0,  0,  0,  0,  0,  0, -3,
+    -3,  0,  2,  2,  2,  2,  0, -3,
+    -2,  0,  2,  2,  2,  2,  0, -2,
+     0,  0,  2,  2,  2,  2,  0, -2,
+    -3,  2,  2,  2,  2,  2,  0, -3,
+    -3,  0,  2,  0,  0,  0,  0, -3,
+    -7, -3, -3, -2, -2, -3, -3, -7,
+};
+
+// sheltered in the middlegame, in the center in the endgame
+static constexpr int king_bonus[2][64] = {
+    {
+       -10,-13,-13,-15,-15,-13,-13,-10,
+       -10,-13,-13,-15,-15,-13,-13,-10,
+       -10,-13,-13,-15,-15,-13,-13,-10,
+       -10,-13,-13,-15,-15,-13,-13,-10,
+        -7,-10,-10,-13,-13,-10,-10, -7,
+        -3, -7, -7, -7, -7, -7, -7, -3,
+         7,  7,  0,  0,  0,  0,  7,  7,
+         7, 10,  3,  0,  0,  3, 10,  7,
+    }, {
+       -15,-12,-10, -8, -8,-10,-12,-15,
+       -10, -7, -3,  0,  0, -3, -7,-10,
+       -10, -3,  7, 10, 10,  7, -3,-10,
+       -10, -3, 10, 13, 13, 10, -3,-10,
+       -10, -3, 10, 13, 13, 10, -3,-10,
+       -10, -3,  7, 10, 10,  7, -3,-10,
+       -10,-10,  0,  0,  0,  0,-10,-10,
+       -15,-10,-10,-10,-10,-10,-10,-15,
+    }
+};
+
+static constexpr int figure_values[7] = {
+    0, PAWN_VALUE, ROOK_VALUE, KNIGHT_VALUE, BISHOP_VALUE, QUEEN_VALUE, KING_VALUE
+};
+
+static constexpr int bonus(int phase, int figure, int drawn_pos)
+{
+    switch (figure) {
+        case PAWN:   return pawn_bonus[phase][drawn_pos];
+        case ROOK:   return rook_bonus[drawn_pos];
+        case KNIGHT: return knight_bonus[drawn_pos];
+        case BISHOP: return bishop_bonus[drawn_pos];
+        case QUEEN:  return queen_bonus[drawn_pos];
+        case KING:   return king_bonus[phase][drawn_pos];
+        default: return 0;
+    }
+}
+
+static constexpr PieceSquareTables generateTables()
+{
+    PieceSquareTables tables{};
+
+    for (int phase = MIDGAME; phase <= ENDGAME; phase++) {
+        for (int figure = PAWN; figure <= KING; figure++) {
+            for (int pos = 0; pos < 64; pos++) {
+                int row = pos / 8, col = pos % 8;
+                // the eighth rank is drawn first for white, the first for black
+                tables.values[phase][0][figure][pos] =
+                    figure_values[figure] + bonus(phase, figure, (7 - row) * 8 + col);
+                tables.values[phase][1][figure][pos] =
+                    -(figure_values[figure] + bonus(phase, figure, row * 8 + col));
+            }
+        }
+    }
+    return tables;
+}
+
+constexpr PieceSquareTables piece_square = generateTables();
+
+// Every extra pawn on a file, every pawn without own pawns on the files
+// next to it
+static const int doubled_penalty[2] = {4, 8};
+static const int isolated_penalty[2] = {4, 6};
+
+// Passed pawns by rank counted from the own side, on top of the table values
+static const int passed_bonus[2][8] = {
+    {0, 1, 2, 4,  7, 12, 18, 0},
+    {0, 3, 5, 9, 15, 24, 36, 0},
+};
+
+struct PawnMasks
+{
+    TBitBoard adjacent_files[8];
+    TBitBoard passed_span[2][64];   // squares of enemy pawns which can stop a pawn
+};
+
+static constexpr PawnMasks generatePawnMasks()
+{
+    PawnMasks masks{};
+
+    for (int col = 0; col < 8; col++) {
+        masks.adjacent_files[col] = (col > 0 ? FILE_A_BB << (col - 1) : 0)
+                                  | (col < 7 ? FILE_A_BB << (col + 1) : 0);
+    }
+    for (int pos = 0; pos < 64; pos++) {
+        int row = pos / 8, col = pos % 8;
+        TBitBoard files = masks.adjacent_files[col] | (FILE_A_BB << col);
+        for (int ahead = row + 1; ahead < 8; ahead++)
+            masks.passed_span[0][pos] |= files & (RANK_1_BB << (ahead * 8));
+        for (int ahead = row - 1; ahead >= 0; ahead--)
+            masks.passed_span[1][pos] |= files & (RANK_1_BB << (ahead * 8));
+    }
+    return masks;
+}
+
+static constexpr PawnMasks pawn_masks = generatePawnMasks();
+
+void evaluatePawns(const ChessBoard & board, int score[2])
+{
+    score[MIDGAME] = score[ENDGAME] = 0;
+
+    for (int color_index = 0; color_index < 2; color_index++) {
+        const int sign = color_index == 0 ? 1 : -1;
+        const TBitBoard own = board.figures_bb[color_index][PAWN];
+        const TBitBoard opponent = board.figures_bb[1 - color_index][PAWN];
+
+        for (int col = 0; col < 8; col++) {
+            int on_file = popCount(own & (FILE_A_BB << col));
+            if (on_file == 0)
+                continue;
+            int isolated = (own & pawn_masks.adjacent_files[col]) ? 0 : on_file;
+            for (int phase = MIDGAME; phase <= ENDGAME; phase++) {
+                score[phase] -= sign * ((on_file - 1) * doubled_penalty[phase]
+                                        + isolated * isolated_penalty[phase]);
+            }
+        }
+
+        TBitBoard pawns = own;
+        while (pawns) {
+            int pos = popLsb(pawns);
+            if (opponent & pawn_masks.passed_span[color_index][pos])
+                continue;
+            int rank = color_index == 0 ? pos / 8 : 7 - pos / 8;
+            score[MIDGAME] += sign * passed_bonus[MIDGAME][rank];
+            score[ENDGAME] += sign * passed_bonus[ENDGAME][rank];
+        }
+    }
+}
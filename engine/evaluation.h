@@ -0,0 +1,41 @@
+#pragma once
+
+class ChessBoard;
+
+// Pieces' values
+#define WIN_VALUE  50000	// win the game
+#define PAWN_VALUE    30	// 8x
+#define ROOK_VALUE    90	// 2x
+#define KNIGHT_VALUE  85	// 2x
+#define BISHOP_VALUE  84	// 2x
+#define QUEEN_VALUE  300	// 1x
+#define KING_VALUE 	 ((PAWN_VALUE * 8) + (ROOK_VALUE * 2) \
+						+ (KNIGHT_VALUE * 2) + (BISHOP_VALUE * 2) + QUEEN_VALUE + WIN_VALUE)
+
+// Game phases the piece-square values are given for
+#define MIDGAME 0
+#define ENDGAME 1
+
+// Figures besides the kings from which on the game is all middlegame,
+// with fewer the endgame values weigh in more and more
+#define PHASE_FIGURES 30
+
+/*
+* Value of every figure on every square, its material included. White
+* figures count positive, black ones negative, so the values of all figures
+* on the board add up to the score from white's point of view.
+*/
+struct PieceSquareTables
+{
+    int values[2][2][7][64];    // [phase][color index][figure type][square]
+};
+
+// Generated at compile time, like the Zobrist keys
+extern const PieceSquareTables piece_square;
+
+/*
+* Doubled, isolated and passed pawns of both sides, white minus black, in
+* the middlegame and in the endgame. Depends on the pawns only, so the
+* result can be kept by the pawn key (see PawnTable).
+*/
+void evaluatePawns(const ChessBoard & board, int score[2]);
@@ -29,6 +29,7 @@ void Global::log(const string &str)
     int seconds = total_sec % 60;
     int minutes = total_min % 60;
 
+    lock_guard<mutex> lock(log_mutex);
     if (file.is_open()) {
         file << "[" << setfill('0') << setw(2)
              << minutes << ":"
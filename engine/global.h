@@ -1,5 +1,6 @@
 #pragma once
 #include <fstream>
+#include <mutex>
 #include <string>
 #include <boost/date_time/posix_time/posix_time.hpp>
 
@@ -22,6 +23,8 @@ public:
     int color = -1;
     std::fstream file;
     boost::posix_time::ptime start;
+    // search threads of different games may log at once
+    std::mutex log_mutex;
 public:
 
 };
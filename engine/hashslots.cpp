@@ -0,0 +1,40 @@
+#include "hashslots.h"
+
+using namespace std;
+
+HashSlots::HashSlots(size_t megabytes)
+{
+    resize(megabytes);
+}
+
+void HashSlots::resize(size_t megabytes)
+{
+    size_t slot_count = 1;
+    while (slot_count * 2 * sizeof(Slot) <= megabytes * 1024 * 1024)
+        slot_count *= 2;
+    slots.reset(new Slot[slot_count]);
+    slot_mask = slot_count - 1;
+    clear();
+}
+
+void HashSlots::clear()
+{
+    for (uint64_t i = 0; i <= slot_mask; i++) {
+        slots[i].key_xor_data.store(0, memory_order_relaxed);
+        slots[i].data.store(0, memory_order_relaxed);
+    }
+}
+
+bool HashSlots::probe(uint64_t key, uint64_t & data) const
+{
+    const Slot & slot = slots[key & slot_mask];
+    data = slot.data.load(memory_order_relaxed);
+    return (slot.key_xor_data.load(memory_order_relaxed) ^ data) == key;
+}
+
+void HashSlots::store(uint64_t key, uint64_t data)
+{
+    Slot & slot = slots[key & slot_mask];
+    slot.key_xor_data.store(key ^ data, memory_order_relaxed);
+    slot.data.store(data, memory_order_relaxed);
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/*
+* Power-of-two array of 64-bit values by hash key, one slot per key, the
+* last writer wins. Shared by all search threads without locks, like the
+* transposition table: a slot holds (key ^ data, data) in two relaxed
+* atomics, so a slot torn by a concurrent writer reads as a miss instead
+* of a wrong value.
+*/
+class HashSlots
+{
+public:
+    explicit HashSlots(size_t megabytes);
+    HashSlots(const HashSlots &) = delete;
+    HashSlots& operator = (const HashSlots &) = delete;
+
+    /*
+    * Reallocates the array with the largest power-of-two slot count that
+    * fits into the given size. All values are lost.
+    */
+    void resize(size_t megabytes);
+
+    void clear();
+
+    bool probe(uint64_t key, uint64_t & data) const;
+    void store(uint64_t key, uint64_t data);
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> key_xor_data;
+        std::atomic<uint64_t> data;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    uint64_t slot_mask = 0;
+};
@@ -50,12 +50,16 @@ void HumanPlayer::showMove(const ChessBoard & orig_board, Move & move)
         default:
             break;
     }
-    double microseconds = measure_evaluation.time_span.count();
+#ifdef PROFILE
+    double microseconds = measure_evaluation.timeSpan().count();
     cout << "Perfomance:"
          << "\n\tEvalutation times(total): " << measure_evaluation.times
          << "\n\tEvalutation time (total): " << microseconds
          << "\n\tEvalutation time per call (total): " << (microseconds / measure_evaluation.times)
+         << "\n\tEvaluation cache hit rate: " << measure_eval_cache.hitRate()
+         << " of " << measure_eval_cache.probes << " probes"
          << endl;
+#endif
 }
 
 
@@ -0,0 +1,234 @@
+#include "moveordering.h"
+#include "aiplayer.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+// Captures and queen promotions go before any quiet move of the stage
+static const int CAPTURE_SCORE   = 1 << 24;
+// history is halved when any entry gets here
+static const int HISTORY_LIMIT   = 1 << 16;
+
+// Ordering values of the figures, the king as attacker goes after the queen
+static const int figure_values[7] = {
+    0, PAWN_VALUE, ROOK_VALUE, KNIGHT_VALUE, BISHOP_VALUE, QUEEN_VALUE, QUEEN_VALUE + PAWN_VALUE
+};
+
+SearchHistory::SearchHistory()
+{
+    clear();
+}
+
+void SearchHistory::clear()
+{
+    for (auto & ply_killers : killers) {
+        ply_killers[0] = EMPTY_MOVE;
+        ply_killers[1] = EMPTY_MOVE;
+    }
+    memset(history, 0, sizeof(history));
+}
+
+void SearchHistory::newSearch()
+{
+    for (auto & ply_killers : killers) {
+        ply_killers[0] = EMPTY_MOVE;
+        ply_killers[1] = EMPTY_MOVE;
+    }
+    for (auto & color : history)
+        for (auto & from : color)
+            for (int & value : from)
+                value /= 2;
+}
+
+void SearchHistory::addCutoff(const Move & move, int ply, int depth)
+{
+    if (ply < MAX_PLY && killers[ply][0].packed() != move.packed()) {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = move;
+    }
+
+    int & value = history[COLOR_INDEX(move.figure)][move.from][move.to];
+    value += depth * depth;
+    if (value >= HISTORY_LIMIT) {
+        for (auto & color : history)
+            for (auto & from : color)
+                for (int & other : from)
+                    other /= 2;
+    }
+}
+
+MovePicker::MovePicker(const ChessBoard & board, unsigned short hash_move, const SearchHistory * history,
+                       int ply)
+ : board(board),
+   history(history),
+   ply(ply),
+   hash_move(hash_move)
+{
+}
+
+MovePicker::MovePicker(const ChessBoard & board)
+ : board(board),
+   history(nullptr),
+   ply(0),
+   stage(QUIESCENT_INIT),
+   hash_move(0)
+{
+}
+
+Move * MovePicker::next()
+{
+    Move * move;
+    unsigned short packed;
+
+    switch (stage) {
+    case HASH_MOVE:
+        stage = CAPTURES_INIT;
+        if (hash_move) {
+            hash_move_full = Move::fromPacked(board, hash_move);
+            if (isPlayable(hash_move_full))
+                return &hash_move_full;
+            hash_move = 0;
+        }
+        // fall through
+    case CAPTURES_INIT:
+        MoveGenerator<true>::getMoves(board, board.next_move_color, moves, moves);
+        for (int i = current; i < moves.size(); i++)
+            scores[i] = score(moves[i]);
+        stage = GOOD_CAPTURES;
+        // fall through
+    case GOOD_CAPTURES:
+        while ((move = pickBest())) {
+            if (move->packed() == hash_move)
+                continue;
+            if (isLosingCapture(*move)) {
+                bad_captures.push_back(*move);
+                continue;
+            }
+            return move;
+        }
+        stage = KILLERS;
+        // fall through
+    case KILLERS:
+        while (history && ply < MAX_PLY && killer_index < 2) {
+            killer = history->killers[ply][killer_index++];
+            packed = killer.packed();
+            if (NOT killer.figure || packed == hash_move)
+                continue;
+            // a killer which takes something here came with the captures
+            if (isPlayable(killer) && isQuiet(killer)) {
+                killers_picked[killer_index - 1] = packed;
+                return &killer;
+            }
+        }
+        stage = QUIETS_INIT;
+        // fall through
+    case QUIETS_INIT:
+        {
+            // captures again, they are not kept
+            MoveList captures;
+            MoveGenerator<false>::getMoves(board, board.next_move_color, moves, captures);
+        }
+        for (int i = current; i < moves.size(); i++)
+            scores[i] = score(moves[i]);
+        stage = QUIETS;
+        // fall through
+    case QUIETS:
+        while ((move = pickBest())) {
+            packed = move->packed();
+            if (packed == hash_move || packed == killers_picked[0] || packed == killers_picked[1])
+                continue;
+            return move;
+        }
+        stage = BAD_CAPTURES;
+        // fall through
+    case BAD_CAPTURES:
+        if (bad_current < bad_captures.size())
+            return &bad_captures[bad_current++];
+        return nullptr;
+    case SORTED:
+        if (current < moves.size())
+            return &moves[current++];
+        return nullptr;
+    case QUIESCENT_INIT:
+        MoveGenerator<true>::getMoves(board, board.next_move_color, moves, moves);
+        for (int i = 0; i < moves.size(); i++)
+            scores[i] = score(moves[i]);
+        stage = QUIESCENT_CAPTURES;
+        // fall through
+    case QUIESCENT_CAPTURES:
+        while ((move = pickBest())) {
+            if (NOT isLosingCapture(*move))
+                return move;
+        }
+        return nullptr;
+    }
+    return nullptr;
+}
+
+Move * MovePicker::sortRemaining()
+{
+    MoveList rest;
+    while (Move * move = next())
+        rest.push_back(*move);
+
+    moves = rest;
+    current = 0;
+    stage = SORTED;
+    return moves.begin();
+}
+
+Move * MovePicker::end()
+{
+    return moves.end();
+}
+
+Move * MovePicker::pickBest()
+{
+    if (current >= moves.size())
+        return nullptr;
+    if (unordered_rest)
+        return &moves[current++];
+
+    int best = current;
+    for (int i = current + 1; i < moves.size(); i++) {
+        if (scores[i] > scores[best])
+            best = i;
+    }
+    // nothing is known about the moves left, no need to look at them again
+    if (scores[best] == 0)
+        unordered_rest = true;
+    swap(moves[current], moves[best]);
+    swap(scores[current], scores[best]);
+    return &moves[current++];
+}
+
+bool MovePicker::isPlayable(Move & move) const
+{
+    return board.isValidMove(board.next_move_color, move);
+}
+
+bool MovePicker::isLosingCapture(const Move & move) const
+{
+    // taking something worth as much as the attacker never loses
+    int gain = figure_values[FIGURE(move.capture)];
+    if (move.promotion == QUEEN)
+        gain += QUEEN_VALUE - PAWN_VALUE;
+    return figure_values[FIGURE(move.figure)] > gain && board.staticExchange(move) < 0;
+}
+
+int MovePicker::score(const Move & move) const
+{
+    // most valuable victim first, least valuable attacker among equal ones
+    if (NOT isQuiet(move)) {
+        int gain = figure_values[FIGURE(move.capture)];
+        if (move.promotion == QUEEN)
+            gain += QUEEN_VALUE - PAWN_VALUE;
+        return CAPTURE_SCORE + gain * 16 - figure_values[FIGURE(move.figure)];
+    }
+
+    if (NOT history)
+        return 0;
+    return history->history[COLOR_INDEX(move.figure)][move.from][move.to];
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include "chessboard.h"
+
+// Deepest ply killer moves are kept for
+#define MAX_PLY 128
+
+/*
+* What a search thread learned about quiet moves: the last two moves per ply
+* which caused a cutoff (killers) and how often a move from one square to
+* another caused a cutoff anywhere in the tree (butterfly history). Every
+* thread has its own, so nothing here needs synchronisation.
+*/
+struct SearchHistory
+{
+    Move killers[MAX_PLY][2];
+    int history[2][64][64];
+
+    SearchHistory();
+
+    void clear();
+
+    /*
+    * Called before each search: old killers do not fit the new position,
+    * history fades out
+    */
+    void newSearch();
+
+    /*
+    * Quiet move which failed high at the given ply and remaining depth
+    */
+    void addCutoff(const Move & move, int ply, int depth);
+};
+
+/*
+* Hands out the moves of a position best first. They are generated in
+* stages, each only when the one before is used up, so a cutoff by the hash
+* move or a capture never pays for the quiet moves:
+*
+* the hash move, captures by MVV-LVA (one losing material by the static
+* exchange evaluation waits till the end), the killers of the ply, the other
+* moves with queen promotions first and by history then, the captures put
+* off.
+*
+* Inside a stage next() does one step of a selection sort: the best of the
+* remaining moves is swapped to the front of them.
+*
+* For the quiescent search there are the captures alone, by MVV-LVA, and
+* only those which do not lose material.
+*/
+class MovePicker
+{
+public:
+    MovePicker(const ChessBoard & board, unsigned short hash_move, const SearchHistory * history, int ply);
+
+    /*
+    * Captures which do not lose material only
+    */
+    explicit MovePicker(const ChessBoard & board);
+
+    /*
+    * Next best move, nullptr when all moves have been picked
+    */
+    Move * next();
+
+    /*
+    * Generates and sorts all moves not picked yet, next() goes on with
+    * them. Returns where they begin, they end at end().
+    */
+    Move * sortRemaining();
+    Move * end();
+
+    /*
+    * Neither a capture nor a queen promotion, under-promotions count as quiet
+    */
+    static bool isQuiet(const Move & move) {
+        return FIGURE(move.capture) == EMPTY && move.promotion != QUEEN;
+    }
+
+private:
+    enum Stage {
+        HASH_MOVE, CAPTURES_INIT, GOOD_CAPTURES, KILLERS, QUIETS_INIT, QUIETS, BAD_CAPTURES, SORTED,
+        QUIESCENT_INIT, QUIESCENT_CAPTURES
+    };
+
+    /*
+    * Best of the moves from current on, swapped to current
+    */
+    Move * pickBest();
+
+    /*
+    * Completes a move kept from another position, false if it cannot be
+    * played in this one
+    */
+    bool isPlayable(Move & move) const;
+
+    bool isLosingCapture(const Move & move) const;
+    int score(const Move & move) const;
+
+    const ChessBoard & board;
+    const SearchHistory * history;
+    int ply;
+    Stage stage = HASH_MOVE;
+
+    unsigned short hash_move;
+    Move hash_move_full;
+    unsigned short killers_picked[2] = {0, 0};
+    Move killer;
+    int killer_index = 0;
+
+    MoveList moves;
+    int scores[MoveList::CAPACITY];
+    int current = 0;
+    bool unordered_rest = false;    // only moves scored 0 are left
+    MoveList bad_captures;
+    int bad_current = 0;
+};
@@ -0,0 +1,30 @@
+#include "pawntable.h"
+
+using namespace std;
+
+PawnTable::PawnTable(size_t megabytes)
+ : slots(megabytes)
+{
+}
+
+void PawnTable::clear()
+{
+    slots.clear();
+}
+
+bool PawnTable::probe(uint64_t key, int score[2]) const
+{
+    uint64_t data;
+    if (!slots.probe(key, data))
+        return false;
+
+    score[0] = static_cast<int32_t>(data & 0xffffffff);
+    score[1] = static_cast<int32_t>(data >> 32);
+    return true;
+}
+
+void PawnTable::store(uint64_t key, const int score[2])
+{
+    uint64_t data = static_cast<uint32_t>(score[0]) | static_cast<uint64_t>(static_cast<uint32_t>(score[1])) << 32;
+    slots.store(key, data);
+}
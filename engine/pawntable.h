@@ -0,0 +1,28 @@
+#pragma once
+#include "hashslots.h"
+
+/*
+* Pawn structure scores by pawn key (ChessBoard::pawn_hash). Pawns move
+* rarely, so most evaluations find the structure of their position here
+* and only the rest has to analyse it. Shared by all search threads.
+*/
+class PawnTable
+{
+public:
+    static const size_t DEFAULT_SIZE_MB = 1;
+
+    explicit PawnTable(size_t megabytes = DEFAULT_SIZE_MB);
+    PawnTable(const PawnTable &) = delete;
+    PawnTable& operator = (const PawnTable &) = delete;
+
+    void clear();
+
+    /*
+    * Middlegame and endgame score of the structure, false if not found
+    */
+    bool probe(uint64_t key, int score[2]) const;
+    void store(uint64_t key, const int score[2]);
+
+private:
+    HashSlots slots;
+};
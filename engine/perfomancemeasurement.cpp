@@ -1,5 +1,8 @@
 #include "perfomancemeasurement.h"
+#include "global.h"
+#include <algorithm>
 PerfomanceMeasurement measure_evaluation;
+CacheMeasurement measure_eval_cache;
 
 PerfomanceMeasurement::PerfomanceMeasurement()
 {
@@ -8,6 +11,63 @@ PerfomanceMeasurement::PerfomanceMeasurement()
 
 void PerfomanceMeasurement::AddMeasure(const std::chrono::microseconds &delta)
 {
-    times++;
-    time_span += delta;
+    times.fetch_add(1, std::memory_order_relaxed);
+    time_span_us.fetch_add(delta.count(), std::memory_order_relaxed);
+}
+
+std::chrono::microseconds PerfomanceMeasurement::timeSpan() const
+{
+    return std::chrono::microseconds(time_span_us.load(std::memory_order_relaxed));
+}
+
+void LatencyMeasurement::AddMeasure(const std::chrono::microseconds & delta)
+{
+    long long us = std::max<long long>(delta.count(), 0);
+    // bucket i holds durations below 2^i microseconds
+    int bucket = 0;
+    while (bucket < BUCKETS - 1 && (1LL << bucket) <= us)
+        bucket++;
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    total_us.fetch_add(us, std::memory_order_relaxed);
+
+    long long old_max = max_us.load(std::memory_order_relaxed);
+    while (us > old_max && NOT max_us.compare_exchange_weak(old_max, us, std::memory_order_relaxed))
+        ;
+}
+
+long long LatencyMeasurement::count() const
+{
+    long long total = 0;
+    for (const std::atomic<long long> & bucket : buckets)
+        total += bucket.load(std::memory_order_relaxed);
+    return total;
+}
+
+std::chrono::microseconds LatencyMeasurement::mean() const
+{
+    long long total = count();
+    return std::chrono::microseconds(total ? total_us.load(std::memory_order_relaxed) / total : 0);
+}
+
+std::chrono::microseconds LatencyMeasurement::max() const
+{
+    return std::chrono::microseconds(max_us.load(std::memory_order_relaxed));
+}
+
+std::chrono::microseconds LatencyMeasurement::percentile(double fraction) const
+{
+    long long total = count();
+    long long wanted = static_cast<long long>(fraction * total), seen = 0;
+    for (int bucket = 0; bucket < BUCKETS; bucket++) {
+        seen += buckets[bucket].load(std::memory_order_relaxed);
+        if (seen > wanted || seen == total)
+            return std::min(std::chrono::microseconds(1LL << bucket), max());
+    }
+    return max();
+}
+
+double CacheMeasurement::hitRate() const
+{
+    long long total = probes.load(std::memory_order_relaxed);
+    return total ? double(hits.load(std::memory_order_relaxed)) / total : 0.0;
 }
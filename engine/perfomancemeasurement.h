@@ -1,6 +1,11 @@
 #pragma once
+#include <atomic>
 #include <chrono>
 
+/*
+* Time spent in a function over all of its calls. Measured by all search
+* threads at once.
+*/
 class PerfomanceMeasurement
 {
 public:
@@ -8,8 +13,59 @@ public:
     PerfomanceMeasurement(const PerfomanceMeasurement &) = delete;
     PerfomanceMeasurement& operator = (const PerfomanceMeasurement &) = delete;
     void AddMeasure(const std::chrono::microseconds & delta);
-    std::chrono::microseconds time_span = std::chrono::microseconds::zero();
-    int times = 0;
+    std::chrono::microseconds timeSpan() const;
+    std::atomic<long long> time_span_us{0};
+    std::atomic<long long> times{0};
+};
+
+/*
+* Lookups into a cache and how many of them found what they were after.
+* Counted by all search threads at once.
+*/
+class CacheMeasurement
+{
+public:
+    CacheMeasurement() = default;
+    CacheMeasurement(const CacheMeasurement &) = delete;
+    CacheMeasurement& operator = (const CacheMeasurement &) = delete;
+    void AddProbe(bool hit)
+    {
+        probes.fetch_add(1, std::memory_order_relaxed);
+        if (hit)
+            hits.fetch_add(1, std::memory_order_relaxed);
+    }
+    double hitRate() const;
+    std::atomic<long long> probes{0};
+    std::atomic<long long> hits{0};
+};
+
+/*
+* Distribution of durations in power of two buckets of microseconds, so
+* percentiles are known to a factor of two. Added to from any thread.
+*/
+class LatencyMeasurement
+{
+public:
+    static const int BUCKETS = 40;
+
+    LatencyMeasurement() = default;
+    LatencyMeasurement(const LatencyMeasurement &) = delete;
+    LatencyMeasurement& operator = (const LatencyMeasurement &) = delete;
+    void AddMeasure(const std::chrono::microseconds & delta);
+
+    long long count() const;
+    std::chrono::microseconds mean() const;
+    std::chrono::microseconds max() const;
+    /*
+    * Upper bound of the bucket the given fraction (0..1) of the durations
+    * falls into
+    */
+    std::chrono::microseconds percentile(double fraction) const;
+
+private:
+    std::atomic<long long> buckets[BUCKETS] = {};
+    std::atomic<long long> total_us{0};
+    std::atomic<long long> max_us{0};
 };
 
 class Point
@@ -37,4 +93,14 @@ private:
 };
 
 extern PerfomanceMeasurement measure_evaluation;
+extern CacheMeasurement measure_eval_cache;
+
+// The points are on the hot path of every search thread: clock readings
+// and atomics shared by all of them. Only profiling builds have them.
+#ifdef PROFILE
 #define EVALUATION_PROF_POINT Point evalutaion_point(&measure_evaluation)
+#define EVAL_CACHE_PROF_POINT(hit) measure_eval_cache.AddProbe(hit)
+#else
+#define EVALUATION_PROF_POINT
+#define EVAL_CACHE_PROF_POINT(hit)
+#endif
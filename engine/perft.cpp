@@ -0,0 +1,105 @@
+#include "perft.h"
+
+using namespace std;
+
+PerftCounters & PerftCounters::operator += (const PerftCounters & other)
+{
+    nodes       += other.nodes;
+    captures    += other.captures;
+    en_passants += other.en_passants;
+    castles     += other.castles;
+    promotions  += other.promotions;
+    checks      += other.checks;
+    return *this;
+}
+
+static void perft(ChessBoard & board, int depth, PerftCounters & counters)
+{
+    MoveList moves;
+    int color = board.next_move_color;
+    MoveGenerator<false>::getMoves(board, color, moves, moves);
+
+    // the generator only returns legal moves, the own king is never looked at
+    for (const Move & move : moves) {
+        bool en_passant = FIGURE(move.capture) != EMPTY && board.square[move.to] == EMPTY;
+
+        board.move(move);
+        if (depth > 1) {
+            perft(board, depth - 1, counters);
+        } else {
+            counters.nodes++;
+            if (FIGURE(move.capture) != EMPTY)
+                counters.captures++;
+            if (en_passant)
+                counters.en_passants++;
+            if (FIGURE(move.figure) == KING && abs(move.to - move.from) == 2)
+                counters.castles++;
+            if (move.promotion != EMPTY)
+                counters.promotions++;
+            if (board.isVulnerable(board.next_move_color ? board.black_king_pos : board.white_king_pos,
+                                   board.next_move_color))
+                counters.checks++;
+        }
+        board.undoMove(move);
+    }
+}
+
+PerftCounters Perft::run(ChessBoard & board, int depth)
+{
+    PerftCounters counters;
+    if (depth <= 0)
+        counters.nodes = 1;
+    else
+        perft(board, depth, counters);
+    return counters;
+}
+
+vector<pair<Move, PerftCounters>> Perft::divide(ChessBoard & board, int depth)
+{
+    vector<pair<Move, PerftCounters>> result;
+    MoveList moves;
+    int color = board.next_move_color;
+    MoveGenerator<false>::getMoves(board, color, moves, moves);
+
+    for (const Move & move : moves) {
+        PerftCounters counters;
+        bool en_passant = FIGURE(move.capture) != EMPTY && board.square[move.to] == EMPTY;
+
+        board.move(move);
+        if (depth > 1) {
+            perft(board, depth - 1, counters);
+        } else {
+            // the root move is the last ply
+            counters.nodes = 1;
+            counters.captures = FIGURE(move.capture) != EMPTY;
+            counters.en_passants = en_passant;
+            counters.castles = FIGURE(move.figure) == KING && abs(move.to - move.from) == 2;
+            counters.promotions = move.promotion != EMPTY;
+            counters.checks = board.isVulnerable(board.next_move_color ? board.black_king_pos : board.white_king_pos,
+                                                 board.next_move_color);
+        }
+        result.emplace_back(move, counters);
+        board.undoMove(move);
+    }
+    return result;
+}
+
+const vector<Perft::Position> & Perft::suite()
+{
+    // https://www.chessprogramming.org/Perft_Results
+    static const vector<Position> positions = {
+        {"startpos", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+            {20, 400, 8902, 197281, 4865609, 119060324}},
+        {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+            {48, 2039, 97862, 4085603, 193690690}},
+        {"position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+            {14, 191, 2812, 43238, 674624, 11030083}},
+        {"position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+            {6, 264, 9467, 422333, 15833292}},
+        {"position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+            {44, 1486, 62379, 2103487, 89941194}},
+        {"position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+            {46, 2079, 89890, 3894594, 164075551}},
+    };
+    return positions;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "chessboard.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+* Counters of a perft run. Everything but nodes counts the moves of the
+* last ply only, like the published tables do.
+*/
+struct PerftCounters
+{
+    unsigned long long nodes = 0;
+    unsigned long long captures = 0;    // en passant included
+    unsigned long long en_passants = 0;
+    unsigned long long castles = 0;
+    unsigned long long promotions = 0;
+    unsigned long long checks = 0;
+
+    PerftCounters & operator += (const PerftCounters & other);
+};
+
+/*
+* Counts the legal move paths of a given length, to validate the move
+* generator and move()/undoMove() against known numbers and to measure
+* their speed.
+*/
+class Perft
+{
+public:
+    struct Position {
+        const char * name;
+        const char * fen;
+        std::vector<unsigned long long> nodes; // expected, index is depth - 1
+    };
+
+    static PerftCounters run(ChessBoard & board, int depth);
+
+    /*
+    * Counters of the subtree of every legal root move
+    */
+    static std::vector<std::pair<Move, PerftCounters>> divide(ChessBoard & board, int depth);
+
+    /*
+    * Well known positions with their node counts (startpos, kiwipete ...)
+    */
+    static const std::vector<Position> & suite();
+};
@@ -0,0 +1,172 @@
+#include "splitsearch.h"
+#include "aiplayer.h"
+#include "moveordering.h"
+
+using namespace std;
+
+SplitPoint::SplitPoint(const AIPlayer * player, const SearchControl * control, const SplitPoint * parent,
+                       const ChessBoard & board, int depth, int ply, int alpha, int beta,
+                       int best_value, const Move & best_move, bool in_check, bool futile)
+ : player(player),
+   control(control),
+   parent(parent),
+   board(board),
+   depth(depth),
+   ply(ply),
+   beta(beta),
+   in_check(in_check),
+   futile(futile),
+   alpha(alpha),
+   best_value(best_value),
+   best_move(best_move)
+{
+}
+
+SplitSearchPool::SplitSearchPool(int workers)
+{
+    for (int i = 0; i < workers; i++)
+        queues.emplace_back(new WorkerQueue());
+
+    // worker 0 is whoever calls split()
+    for (int i = 1; i < workers; i++)
+        threads.emplace_back(&SplitSearchPool::workerLoop, this, i);
+}
+
+SplitSearchPool::~SplitSearchPool()
+{
+    {
+        lock_guard<mutex> lock(idle_mutex);
+        quit = true;
+    }
+    work_available.notify_all();
+    for (thread & worker : threads)
+        worker.join();
+}
+
+int SplitSearchPool::size() const
+{
+    return queues.size();
+}
+
+bool SplitSearchPool::hasIdleWorkers() const
+{
+    return idle.load(memory_order_relaxed) > 0;
+}
+
+void SplitSearchPool::split(SplitPoint & split_point, const Move * begin, const Move * end, int searched,
+                            SearchControl & control, ChessBoard & board)
+{
+    int count = end - begin;
+    split_point.pending = count;
+    {
+        // reversed, so the owner takes them from the back in the given order
+        WorkerQueue & queue = *queues[control.worker];
+        lock_guard<mutex> lock(queue.mutex);
+        for (const Move * move = end; move != begin; ) {
+            --move;
+            queue.tasks.push_back({&split_point, *move, searched + int(move - begin)});
+        }
+    }
+    queued += count;
+    {
+        // no worker may miss the notification between its check and its wait
+        lock_guard<mutex> lock(idle_mutex);
+    }
+    work_available.notify_all();
+
+    // helpful master: while waiting for the thieves only tasks below this
+    // split point are taken, so the owner is back as soon as it is done
+    while (split_point.pending.load(memory_order_acquire) > 0) {
+        SplitTask task;
+        if (popOwn(control.worker, &split_point, task))
+            run(task, control, &board);
+        else if (steal(control.worker, &split_point, task))
+            run(task, control, nullptr);
+        else
+            this_thread::yield();
+    }
+}
+
+unsigned long long SplitSearchPool::takeNodes()
+{
+    return nodes.exchange(0);
+}
+
+bool SplitSearchPool::popOwn(int worker, const SplitPoint * split_point, SplitTask & task)
+{
+    WorkerQueue & queue = *queues[worker];
+    lock_guard<mutex> lock(queue.mutex);
+    if (queue.tasks.empty() || queue.tasks.back().split_point != split_point)
+        return false;
+    task = queue.tasks.back();
+    queue.tasks.pop_back();
+    queued--;
+    return true;
+}
+
+bool SplitSearchPool::steal(int thief, const SplitPoint * ancestor, SplitTask & task)
+{
+    int workers = queues.size();
+    for (int i = 1; i < workers; i++) {
+        WorkerQueue & queue = *queues[(thief + i) % workers];
+        lock_guard<mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+            continue;
+        if (ancestor && NOT queue.tasks.front().split_point->isBelow(ancestor))
+            continue;
+        task = queue.tasks.front();
+        queue.tasks.pop_front();
+        queued--;
+        return true;
+    }
+    return false;
+}
+
+void SplitSearchPool::run(const SplitTask & task, SearchControl & control, ChessBoard * board)
+{
+    SplitPoint & split_point = *task.split_point;
+    if (NOT split_point.cancelled()) {
+        if (board) {
+            split_point.player->searchSplitMove(split_point, task.move, task.searched, control, *board);
+        } else {
+            ChessBoard copy = split_point.board;
+            split_point.player->searchSplitMove(split_point, task.move, task.searched, control, copy);
+        }
+    }
+    // the split point may be gone right after this
+    split_point.pending.fetch_sub(1, memory_order_acq_rel);
+}
+
+void SplitSearchPool::workerLoop(int worker)
+{
+    // kept for the life of the worker, whatever search the tasks belong to
+    SearchHistory history;
+
+    while (true) {
+        SplitTask task;
+        if (steal(worker, nullptr, task)) {
+            // limits of the search the task belongs to, own node counter
+            const SearchControl & owner = *task.split_point->control;
+            SearchControl control;
+            control.start         = owner.start;
+            control.deadline      = owner.deadline;
+            control.use_deadline  = owner.use_deadline;
+            control.stop          = owner.stop;
+            control.interruptible = owner.interruptible;
+            control.pool          = this;
+            control.worker        = worker;
+            control.history       = &history;
+
+            run(task, control, nullptr);
+            nodes += control.nodes;
+            continue;
+        }
+
+        unique_lock<mutex> lock(idle_mutex);
+        idle++;
+        work_available.wait(lock, [this]() { return quit || queued.load() > 0; });
+        idle--;
+        if (quit)
+            return;
+    }
+}
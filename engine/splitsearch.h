@@ -0,0 +1,128 @@
+#pragma once
+#include "chessboard.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class AIPlayer;
+struct SearchControl;
+
+/*
+* Node of the search whose remaining moves are searched by several threads
+* (Young Brothers Wait: only after the first move has been searched). Lives
+* on the stack of the thread that split, which waits till every move is
+* done.
+*/
+struct SplitPoint
+{
+    SplitPoint(const AIPlayer * player, const SearchControl * control, const SplitPoint * parent,
+               const ChessBoard & board, int depth, int ply, int alpha, int beta,
+               int best_value, const Move & best_move, bool in_check, bool futile);
+
+    /*
+    * True if this or any enclosing split point has been cut off, whatever
+    * is searched below it is not needed any more
+    */
+    bool cancelled() const {
+        for (const SplitPoint * split_point = this; split_point; split_point = split_point->parent) {
+            if (split_point->cutoff.load(std::memory_order_relaxed))
+                return true;
+        }
+        return false;
+    }
+
+    bool isBelow(const SplitPoint * ancestor) const {
+        for (const SplitPoint * split_point = this; split_point; split_point = split_point->parent) {
+            if (split_point == ancestor)
+                return true;
+        }
+        return false;
+    }
+
+    const AIPlayer * player;
+    const SearchControl * control;  // of the thread that split
+    const SplitPoint * parent;
+    ChessBoard board;               // position of the node, copied by thieves
+
+    int depth;
+    int ply;
+    int beta;
+    bool in_check;
+    bool futile;                    // quiet moves cannot reach alpha
+    std::atomic<int> alpha;
+    std::atomic<bool> cutoff{false};
+    std::atomic<bool> aborted{false};   // a move was given up on, the result is incomplete
+    std::atomic<int> pending{0};    // moves not searched completely
+
+    std::mutex mutex;               // guards the best move
+    int best_value;
+    Move best_move;
+};
+
+struct SplitTask
+{
+    SplitPoint * split_point;
+    Move move;
+    int searched;                   // moves of the node before this one
+};
+
+/*
+* Workers for the split point search. Worker 0 is the thread calling the
+* search, the others are owned by the pool. Every worker has a deque of
+* tasks: it pushes the moves of its split points and takes them back from
+* the back, idle workers steal from the front, where the moves least
+* likely to matter are.
+*/
+class SplitSearchPool
+{
+public:
+    explicit SplitSearchPool(int workers);
+    ~SplitSearchPool();
+    SplitSearchPool(const SplitSearchPool &) = delete;
+    SplitSearchPool& operator = (const SplitSearchPool &) = delete;
+
+    int size() const;
+
+    bool hasIdleWorkers() const;
+
+    /*
+    * Queues the moves [begin, end) of the split point, which come after
+    * searched ones, and searches them together with the workers which
+    * steal them. Returns when all of them
+    * are done, the result is in the split point. If any of them was
+    * aborted the split point says so and its result is garbage.
+    */
+    void split(SplitPoint & split_point, const Move * begin, const Move * end, int searched,
+               SearchControl & control, ChessBoard & board);
+
+    /*
+    * Positions searched by the pool threads since the last call
+    */
+    unsigned long long takeNodes();
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<SplitTask> tasks;
+    };
+
+    bool popOwn(int worker, const SplitPoint * split_point, SplitTask & task);
+    bool steal(int thief, const SplitPoint * ancestor, SplitTask & task);
+    void run(const SplitTask & task, SearchControl & control, ChessBoard * board);
+    void workerLoop(int worker);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex idle_mutex;
+    std::condition_variable work_available;
+    std::atomic<int> queued{0};
+    std::atomic<int> idle{0};
+    std::atomic<unsigned long long> nodes{0};
+    bool quit = false;
+};
@@ -0,0 +1,150 @@
+#include "transpositiontable.h"
+#include <climits>
+#include <new>
+
+// Layout of the data word:
+// bits  0-15 move, 16-47 score, 48-55 depth, 56-57 bound, 58-63 generation
+static const int DEPTH_OFFSET = 128;
+static const uint8_t GENERATION_MASK = 0x3F;
+
+static inline uint64_t packData(unsigned short move, int score, int depth,
+    TranspositionTable::Bound bound, uint8_t generation)
+{
+    return static_cast<uint64_t>(move)
+         | static_cast<uint64_t>(static_cast<uint32_t>(score)) << 16
+         | static_cast<uint64_t>(static_cast<uint8_t>(depth + DEPTH_OFFSET)) << 48
+         | static_cast<uint64_t>(bound) << 56
+         | static_cast<uint64_t>(generation & GENERATION_MASK) << 58;
+}
+
+static inline int dataDepth(uint64_t data)
+{
+    return static_cast<int>((data >> 48) & 0xFF) - DEPTH_OFFSET;
+}
+
+static inline TranspositionTable::Bound dataBound(uint64_t data)
+{
+    return static_cast<TranspositionTable::Bound>((data >> 56) & 0x03);
+}
+
+static inline uint8_t dataGeneration(uint64_t data)
+{
+    return data >> 58;
+}
+
+TranspositionTable::TranspositionTable(size_t megabytes)
+{
+    resize(megabytes);
+}
+
+void TranspositionTable::resize(size_t megabytes)
+{
+    size_t bytes = megabytes * 1024 * 1024;
+    bucket_count = 1;
+    while (bucket_count * 2 * sizeof(Bucket) <= bytes)
+        bucket_count *= 2;
+    bucket_mask = bucket_count - 1;
+
+    // operator new does not honour alignas(64) before C++17
+    memory.reset(new char[bucket_count * sizeof(Bucket) + alignof(Bucket)]);
+    uintptr_t address = reinterpret_cast<uintptr_t>(memory.get());
+    address = (address + alignof(Bucket) - 1) & ~(uintptr_t(alignof(Bucket)) - 1);
+    buckets = reinterpret_cast<Bucket *>(address);
+
+    for (size_t i = 0; i < bucket_count; i++)
+        new (&buckets[i]) Bucket();
+    clear();
+}
+
+void TranspositionTable::clear()
+{
+    for (size_t i = 0; i < bucket_count; i++) {
+        for (Slot & slot : buckets[i].slots) {
+            slot.key_xor_data.store(0, std::memory_order_relaxed);
+            slot.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    generation = 0;
+}
+
+void TranspositionTable::newSearch()
+{
+    generation = (generation + 1) & GENERATION_MASK;
+}
+
+bool TranspositionTable::probe(uint64_t key, Entry & entry) const
+{
+    const Bucket & b = bucket(key);
+    for (const Slot & slot : b.slots) {
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        uint64_t key_xor_data = slot.key_xor_data.load(std::memory_order_relaxed);
+        if ((key_xor_data ^ data) != key || dataBound(data) == BOUND_NONE)
+            continue;
+
+        entry.move  = data & 0xFFFF;
+        entry.score = static_cast<int32_t>(static_cast<uint32_t>(data >> 16));
+        entry.depth = dataDepth(data);
+        entry.bound = dataBound(data);
+        return true;
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, int depth, Bound bound, int score, unsigned short move)
+{
+    Bucket & b = bucket(key);
+    Slot * replace = nullptr;
+    int worst = INT_MAX;
+
+    for (Slot & slot : b.slots) {
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        uint64_t key_xor_data = slot.key_xor_data.load(std::memory_order_relaxed);
+
+        if (dataBound(data) == BOUND_NONE) {
+            replace = &slot;
+            break;
+        }
+        if ((key_xor_data ^ data) == key) {
+            // keep a deeper result of this search unless the new one is exact
+            if (bound != BOUND_EXACT && dataGeneration(data) == generation
+                    && dataDepth(data) > depth + 2)
+                return;
+            // a bound without a best move should not drop a known one
+            if (move == 0)
+                move = data & 0xFFFF;
+            replace = &slot;
+            break;
+        }
+
+        // shallow entries of older searches go first
+        int age = (generation - dataGeneration(data)) & GENERATION_MASK;
+        int value = dataDepth(data) - 8 * age;
+        if (value < worst) {
+            worst = value;
+            replace = &slot;
+        }
+    }
+
+    uint64_t data = packData(move, score, depth, bound, generation);
+    replace->data.store(data, std::memory_order_relaxed);
+    replace->key_xor_data.store(key ^ data, std::memory_order_relaxed);
+}
+
+size_t TranspositionTable::getSizeMb() const
+{
+    return bucket_count * sizeof(Bucket) / (1024 * 1024);
+}
+
+int TranspositionTable::usagePermill() const
+{
+    size_t sample = bucket_count < 250 ? bucket_count : 250;
+    int used = 0;
+    for (size_t i = 0; i < sample; i++) {
+        for (const Slot & slot : buckets[i].slots) {
+            uint64_t data = slot.data.load(std::memory_order_relaxed);
+            if (dataBound(data) != BOUND_NONE && dataGeneration(data) == generation)
+                used++;
+        }
+    }
+    return used * 1000 / static_cast<int>(sample * BUCKET_SIZE);
+}
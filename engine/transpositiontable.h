@@ -0,0 +1,87 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/*
+* Fixed-size hash table of search results, shared by everything searching
+* the same game. Buckets are one cache line with four entries each.
+*
+* There are no locks: an entry is stored as (key ^ data, data) in two
+* relaxed atomics. A reader recomputes the key from both words and drops
+* the entry if it does not match, so an entry torn by a concurrent writer
+* looks like a miss instead of a wrong result.
+*/
+class TranspositionTable
+{
+public:
+    enum Bound {
+        BOUND_NONE  = 0,
+        BOUND_UPPER = 1, // score is at most this (failed low)
+        BOUND_LOWER = 2, // score is at least this (failed high)
+        BOUND_EXACT = 3
+    };
+
+    struct Entry {
+        unsigned short move = 0; // Move::packed(), 0 if none
+        int score = 0;
+        int depth = 0;
+        Bound bound = BOUND_NONE;
+    };
+
+    static const size_t DEFAULT_SIZE_MB = 16;
+
+    explicit TranspositionTable(size_t megabytes = DEFAULT_SIZE_MB);
+    TranspositionTable(const TranspositionTable &) = delete;
+    TranspositionTable& operator = (const TranspositionTable &) = delete;
+
+    /*
+    * Reallocates the table with the largest power-of-two bucket count that
+    * fits into the given size. All entries are lost. Nobody may search the
+    * table meanwhile.
+    */
+    void resize(size_t megabytes);
+
+    void clear();
+
+    /*
+    * Starts a new search, entries of older searches are replaced first.
+    * Only the player owning the table may start one, the searches of
+    * another player would age its entries.
+    */
+    void newSearch();
+
+    bool probe(uint64_t key, Entry & entry) const;
+    void store(uint64_t key, int depth, Bound bound, int score, unsigned short move);
+
+    size_t getSizeMb() const;
+
+    /*
+    * Entries of the current search per thousand, sampled from the
+    * first buckets
+    */
+    int usagePermill() const;
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> key_xor_data;
+        std::atomic<uint64_t> data;
+    };
+
+    static const int BUCKET_SIZE = 4;
+    struct alignas(64) Bucket {
+        Slot slots[BUCKET_SIZE];
+    };
+
+    Bucket & bucket(uint64_t key) const {
+        return buckets[key & bucket_mask];
+    }
+
+    std::unique_ptr<char[]> memory;
+    Bucket * buckets = nullptr;
+    uint64_t bucket_mask = 0;
+    size_t bucket_count = 0;
+    uint8_t generation = 0;
+};
+
+typedef std::shared_ptr<TranspositionTable> TTranspositionTablePtr;
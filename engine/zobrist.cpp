@@ -0,0 +1,35 @@
+#include "zobrist.h"
+
+/*
+* SplitMix64 step, good enough to spread a counter into random keys
+*/
+static constexpr uint64_t splitMix64(uint64_t & state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static constexpr ZobristKeys generateKeys()
+{
+    ZobristKeys keys{};
+    uint64_t state = 0x5EED5EED5EED5EEDULL;
+
+    for (int color = 0; color < 2; color++)
+        for (int figure = 0; figure < 7; figure++)
+            for (int pos = 0; pos < 64; pos++)
+                keys.figures[color][figure][pos] = splitMix64(state);
+
+    // no castling rights, no key
+    for (int rights = 1; rights < 16; rights++)
+        keys.castling[rights] = splitMix64(state);
+
+    for (int file = 0; file < 8; file++)
+        keys.passant[file] = splitMix64(state);
+
+    keys.black_to_move = splitMix64(state);
+    return keys;
+}
+
+constexpr ZobristKeys zobrist = generateKeys();
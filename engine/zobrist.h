@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+
+/*
+* Random keys for hashing a position. A position key is the XOR of the keys
+* of all figures on their squares, of the castling rights, of the file of
+* the en passant pawn and of the side to move (for black only).
+*/
+struct ZobristKeys
+{
+    uint64_t figures[2][7][64]; // [color index][figure type][square]
+    uint64_t castling[16];      // by castling rights mask
+    uint64_t passant[8];        // by file of the passant pawn
+    uint64_t black_to_move;
+};
+
+// Generated at compile time, so it is ready before any static initialisation
+extern const ZobristKeys zobrist;
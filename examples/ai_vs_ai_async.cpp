@@ -1,5 +1,6 @@
 #include "asyncgame.h"
 #include "asyncaiplayer.h"
+#include <iostream>
 #include <thread>
 
 using namespace std;
@@ -10,7 +11,7 @@ int main()
     thread threads[5];
 
 
-    shared_ptr<AsyncAiPlayer> players[2] = {make_shared<AsyncAiPlayer>(WHITE, 2), make_shared<AsyncAiPlayer>(WHITE, 2)};
+    shared_ptr<AsyncAiPlayer> players[2] = {make_shared<AsyncAiPlayer>(WHITE, 2), make_shared<AsyncAiPlayer>(BLACK, 2)};
     AsyncGame game(io_ptr, players[0], players[1]);
     game.start([io_ptr](AsyncPlayer::EndStatus end_status) {
         switch (end_status) {
@@ -23,6 +24,8 @@ int main()
         case AsyncPlayer::WHITE_LOOSE:
             cout << "White loose" << endl;
             break;
+        default:
+            break;
         }
         io_ptr->stop();
     });
@@ -1,5 +1,6 @@
 #include <functional>
 #include <string>
+#include <list>
 #include <utility>
 #include <iostream>
 #include <limits.h>
@@ -7,12 +8,24 @@
 #include <string>
 #include <exception>
 #include <boost/optional.hpp>
+#include <chrono>
+#include <thread>
+#include <future>
+#include <sstream>
 
 #include "gtest/gtest.h"
 
 #include "tests.h"
 #include "aiplayer.h"
 #include "config.h"
+#include "moveordering.h"
+#include "perft.h"
+#include "pawntable.h"
+#include "evalcache.h"
+#include "perfomancemeasurement.h"
+#include "compactposition.h"
+#include "asyncgame.h"
+#include "asyncaiplayer.h"
 
 using namespace std;
 using namespace boost;
@@ -118,7 +131,7 @@ void Tests::WrongAppearingFigures()
     auto apply_single_move = [&](string smove) -> Move {
         optional<Move> omove;
         omove = Move::fromString(board, smove);
-        std::list<Move> moves;
+        MoveList moves;
         MoveGenerator<false>::getMoves(board, board.next_move_color, moves, moves);
         for (Move & move : moves) {
             if (move.to == omove->to) {
@@ -132,7 +145,7 @@ void Tests::WrongAppearingFigures()
     auto apply_single_capture = [&](string smove) -> Move {
         optional<Move> omove;
         omove = Move::fromString(board, smove);
-        std::list<Move> moves, captures;
+        MoveList moves, captures;
         MoveGenerator<false>::getMoves(board, board.next_move_color, moves, captures);
         for (Move & move : captures) {
             if (move.to == omove->to) {
@@ -166,6 +179,941 @@ void Tests::WrongAppearingFigures()
     EXPECT_TRUE(board.square[F4] && IS_PASSANT(board.square[F4]));
 
 }
+void Tests::BitBoardsInSync()
+{
+    auto expect_in_sync = [](const ChessBoard & board) {
+        ChessBoard rebuilt = board;
+        rebuilt.refreshFigures();
+        for (int color = 0; color < 2; color++) {
+            for (int figure = PAWN; figure <= KING; figure++) {
+                EXPECT_EQ(board.figures_bb[color][figure], rebuilt.figures_bb[color][figure]);
+            }
+            EXPECT_EQ(board.color_bb[color], rebuilt.color_bb[color]);
+        }
+        EXPECT_EQ(board.occupied_bb, rebuilt.occupied_bb);
+        EXPECT_EQ(board.psq_score[MIDGAME], rebuilt.psq_score[MIDGAME]);
+        EXPECT_EQ(board.psq_score[ENDGAME], rebuilt.psq_score[ENDGAME]);
+        EXPECT_EQ(board.pawn_hash, rebuilt.pawn_hash);
+    };
+
+    // castlings and en passant captures are available within two plies
+    board.loadFEN("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    MoveList moves;
+    MoveGenerator<false>::getMoves(board, board.next_move_color, moves, moves);
+    for (Move & move : moves) {
+        board.move(move);
+        expect_in_sync(board);
+
+        MoveList replies;
+        MoveGenerator<false>::getMoves(board, board.next_move_color, replies, replies);
+        for (Move & reply : replies) {
+            board.move(reply);
+            expect_in_sync(board);
+            board.undoMove(reply);
+        }
+
+        board.undoMove(move);
+        expect_in_sync(board);
+    }
+}
+void Tests::SlidingAttacks()
+{
+    // walk the rays of a slider square by square
+    auto walk = [](int pos, TBitBoard occupied, const int (*steps)[2]) {
+        TBitBoard result = 0;
+        for (int i = 0; i < 4; i++) {
+            int row = pos / 8 + steps[i][0], col = pos % 8 + steps[i][1];
+            for (; row >= 0 && row < 8 && col >= 0 && col < 8; row += steps[i][0], col += steps[i][1]) {
+                result |= BIT(row * 8 + col);
+                if (occupied & BIT(row * 8 + col))
+                    break;
+            }
+        }
+        return result;
+    };
+    const int rook_steps[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    const int bishop_steps[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+
+    TBitBoard occupied = 0x0123456789ABCDEFULL;
+    for (int i = 0; i < 1000; i++) {
+        // xorshift, sparse and dense occupancies alike
+        occupied ^= occupied << 13;
+        occupied ^= occupied >> 7;
+        occupied ^= occupied << 17;
+        TBitBoard sample = (i % 2) ? occupied : occupied & (occupied >> 11);
+        for (int pos = 0; pos < 64; pos++) {
+            EXPECT_EQ(rookAttacks(pos, sample), walk(pos, sample, rook_steps));
+            EXPECT_EQ(bishopAttacks(pos, sample), walk(pos, sample, bishop_steps));
+        }
+    }
+}
+void Tests::PackedMoves()
+{
+    // en passant, double steps, castlings and promotions
+    const char * positions[] = {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "k7/1P6/8/3pP3/8/8/6p1/K6R w - d6 0 1",
+    };
+    for (const char * position : positions) {
+        board.loadFEN(position);
+        MoveList moves;
+        MoveGenerator<false>::getMoves(board, board.next_move_color, moves, moves);
+        for (const Move & move : moves) {
+            EXPECT_TRUE(Move::fromPacked(board, move.packed()) == move) << move.toString();
+        }
+    }
+}
+void Tests::ZobristHash()
+{
+    board.loadFEN("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    uint64_t initial_hash = board.hash;
+    EXPECT_EQ(board.hash, board.computeHash());
+
+    MoveList moves;
+    MoveGenerator<false>::getMoves(board, board.next_move_color, moves, moves);
+    for (Move & move : moves) {
+        board.move(move);
+        EXPECT_EQ(board.hash, board.computeHash()) << move.toString();
+
+        MoveList replies;
+        MoveGenerator<false>::getMoves(board, board.next_move_color, replies, replies);
+        for (Move & reply : replies) {
+            board.move(reply);
+            EXPECT_EQ(board.hash, board.computeHash()) << move.toString() << reply.toString();
+            board.undoMove(reply);
+        }
+
+        board.undoMove(move);
+    }
+    EXPECT_EQ(board.hash, initial_hash);
+
+    // transpositions share the key, the side to move does not
+    board.initDefaultSetup();
+    uint64_t start_hash = board.hash;
+    for (const char * str : {"g1f3", "g8f6", "f3g1", "f6g8"}) {
+        board.move(*Move::fromString(board, str));
+    }
+    EXPECT_EQ(board.hash, start_hash);
+    board.toogleColor();
+    EXPECT_NE(board.hash, start_hash);
+
+    // lost castling rights change the key
+    board.loadFEN("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1");
+    uint64_t castling_hash = board.hash;
+    board.loadFEN("r3k2r/8/8/8/8/8/8/R3K2R w Kkq - 0 1");
+    EXPECT_NE(board.hash, castling_hash);
+}
+void Tests::TranspositionTableEntries()
+{
+    TranspositionTable table(1);
+    TranspositionTable::Entry entry;
+    EXPECT_EQ(table.getSizeMb(), 1u);
+
+    uint64_t key = 0x123456789abcdef0ULL;
+    EXPECT_FALSE(table.probe(key, entry));
+
+    table.store(key, 5, TranspositionTable::BOUND_LOWER, -KING_VALUE, 0x0abc);
+    ASSERT_TRUE(table.probe(key, entry));
+    EXPECT_EQ(entry.depth, 5);
+    EXPECT_EQ(entry.bound, TranspositionTable::BOUND_LOWER);
+    EXPECT_EQ(entry.score, -KING_VALUE);
+    EXPECT_EQ(entry.move, 0x0abc);
+
+    // same bucket, other position
+    EXPECT_FALSE(table.probe(key ^ 0x8000000000000000ULL, entry));
+
+    // a shallow bound does not replace a deeper result of the same search
+    table.store(key, 2, TranspositionTable::BOUND_UPPER, 10, 0);
+    ASSERT_TRUE(table.probe(key, entry));
+    EXPECT_EQ(entry.depth, 5);
+    // but an exact one does, keeping the known move
+    table.store(key, 2, TranspositionTable::BOUND_EXACT, 10, 0);
+    ASSERT_TRUE(table.probe(key, entry));
+    EXPECT_EQ(entry.depth, 2);
+    EXPECT_EQ(entry.move, 0x0abc);
+
+    // a full bucket drops its shallowest entry
+    for (int depth = 1; depth <= 4; depth++)
+        table.store(key + (uint64_t(depth) << 40), depth, TranspositionTable::BOUND_EXACT, depth, 0);
+    EXPECT_FALSE(table.probe(key + (uint64_t(1) << 40), entry));
+    EXPECT_TRUE(table.probe(key + (uint64_t(4) << 40), entry));
+
+    table.clear();
+    EXPECT_FALSE(table.probe(key, entry));
+
+    // the table outlives a search and the same search gives the same answer
+    board.loadFEN("6k1/8/6K1/8/1B6/8/8/3B4 w - - 2 3");
+    AIPlayer player(board.next_move_color, 4);
+    AdvancedMoveData first, second;
+    Move move;
+    EXPECT_TRUE(player.getMove(board, move, &first));
+    EXPECT_TRUE(player.getMove(board, move, &second));
+    EXPECT_EQ(first.board_evaluation, second.board_evaluation);
+    EXPECT_EQ(move.from, D1);
+    EXPECT_EQ(move.to, B3);
+
+    // a mate counts from the root, found in the table at another ply it is
+    // as many plies away from the node as before
+    board.loadFEN("6k1/5ppp/8/8/8/8/8/K2R4 w - - 0 1");
+    AIPlayer mating(WHITE, 2);
+    EvaluationInformation info;
+    info.depth = 2;
+    info.ply   = 1;
+    info.alpha = -KING_VALUE;
+    info.beta  = KING_VALUE;
+    EXPECT_EQ(mating.evalAlphaBeta(board, &info), WIN_VALUE - 2);
+    ASSERT_TRUE(mating.getTranspositionTable()->probe(board.hash, entry));
+    EXPECT_EQ(entry.score, WIN_VALUE - 1);
+    info.ply   = 5;
+    EXPECT_EQ(mating.evalAlphaBeta(board, &info), WIN_VALUE - 6);
+}
+void Tests::TimeBudget()
+{
+    using namespace std::chrono;
+    board.loadFEN("r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4");
+    string fen = board.toFEN();
+
+    // bounded by time only, the best move of a finished iteration is played
+    AIPlayer player(board.next_move_color, milliseconds(200));
+    Move move = EMPTY_MOVE;
+    AdvancedMoveData advanced;
+    steady_clock::time_point start = steady_clock::now();
+    EXPECT_TRUE(player.getMove(board, move, &advanced));
+    EXPECT_LT(steady_clock::now() - start, milliseconds(1000));
+    EXPECT_GE(advanced.depth, 1);
+    EXPECT_LT(advanced.depth, MAX_SEARCH_DEPTH);
+    EXPECT_TRUE(board.isValidMove(board.next_move_color, move));
+    EXPECT_EQ(board.toFEN(), fen);
+
+    // the time for a move comes from the clock
+    AIPlayer clock_player(board.next_move_color, MAX_SEARCH_DEPTH);
+    clock_player.setClock(milliseconds(3000), milliseconds(0), 10);
+    start = steady_clock::now();
+    EXPECT_TRUE(clock_player.getMove(board, move, &advanced));
+    EXPECT_LT(steady_clock::now() - start, milliseconds(1300));
+    EXPECT_TRUE(board.isValidMove(board.next_move_color, move));
+
+    // stop() from another thread ends a search without a limit
+    AIPlayer unlimited(board.next_move_color, MAX_SEARCH_DEPTH);
+    std::thread stopper([&unlimited]() {
+        std::this_thread::sleep_for(milliseconds(200));
+        unlimited.stop();
+    });
+    EXPECT_TRUE(unlimited.getMove(board, move, &advanced));
+    stopper.join();
+    EXPECT_GE(advanced.depth, 1);
+    EXPECT_TRUE(board.isValidMove(board.next_move_color, move));
+    EXPECT_EQ(board.toFEN(), fen);
+}
+void Tests::LazySmp()
+{
+    board.loadFEN("6k1/8/6K1/8/1B6/8/8/3B4 w - - 2 3");
+    string fen = board.toFEN();
+
+    AIPlayer single(board.next_move_color, 4);
+    AIPlayer parallel(board.next_move_color, 4);
+    parallel.setThreads(4);
+    EXPECT_EQ(parallel.getThreads(), 4);
+
+    Move move = EMPTY_MOVE;
+    AdvancedMoveData single_data, parallel_data;
+    EXPECT_TRUE(single.getMove(board, move, &single_data));
+    EXPECT_TRUE(parallel.getMove(board, move, &parallel_data));
+    EXPECT_EQ(move.from, D1);
+    EXPECT_EQ(move.to, B3);
+    EXPECT_EQ(parallel_data.depth, 4);
+    EXPECT_EQ(parallel_data.board_evaluation, single_data.board_evaluation);
+    EXPECT_EQ(board.toFEN(), fen);
+}
+void Tests::SplitPoints()
+{
+    const char * positions[] = {
+        "6k1/8/6K1/8/1B6/8/8/3B4 w - - 2 3",
+        "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+    };
+    // the moves given to other threads are pruned and reduced the same way
+    for (int pruning : {0, int(AIPlayer::AllPruning)})
+    for (const char * position : positions) {
+        board.loadFEN(position);
+        string fen = board.toFEN();
+
+        AIPlayer single(board.next_move_color, 4);
+        AIPlayer parallel(board.next_move_color, 4);
+        single.setPruning(pruning);
+        parallel.setPruning(pruning);
+        parallel.setThreads(4);
+        parallel.setParallelMode(AIPlayer::YoungBrothersWait);
+
+        Move move = EMPTY_MOVE;
+        AdvancedMoveData single_data, parallel_data;
+        EXPECT_TRUE(single.getMove(board, move, &single_data));
+        // twice, the threads are kept between moves
+        EXPECT_TRUE(parallel.getMove(board, move, &parallel_data));
+        EXPECT_TRUE(parallel.getMove(board, move, &parallel_data));
+        EXPECT_EQ(parallel_data.depth, 4);
+        // a late move is reduced against the alpha its brothers have reached
+        // when it starts, so with reductions only a mate is sure to be the same
+        if (pruning == 0 || abs(single_data.board_evaluation) > WIN_VALUE / 2) {
+            EXPECT_EQ(parallel_data.board_evaluation, single_data.board_evaluation) << position << " " << pruning;
+        }
+        EXPECT_TRUE(board.isValidMove(board.next_move_color, move));
+        EXPECT_EQ(board.toFEN(), fen);
+    }
+
+    // deep enough for reductions to matter the tree is about the one of a
+    // single thread, not one where the later moves are searched in full
+    board.loadFEN(positions[1]);
+    AIPlayer single(board.next_move_color, 6);
+    AIPlayer parallel(board.next_move_color, 6);
+    parallel.setThreads(4);
+    parallel.setParallelMode(AIPlayer::YoungBrothersWait);
+    Move move = EMPTY_MOVE;
+    AdvancedMoveData single_data, parallel_data;
+    EXPECT_TRUE(single.getMove(board, move, &single_data));
+    EXPECT_TRUE(parallel.getMove(board, move, &parallel_data));
+    EXPECT_LT(parallel_data.nodes, 2 * single_data.nodes);
+}
+void Tests::SplitPointsDeadline()
+{
+    using namespace std::chrono;
+    board.loadFEN("r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4");
+    string fen = board.toFEN();
+    MoveList moves;
+    MoveGenerator<false>::getMoves(board, board.next_move_color, moves, moves);
+
+    // the deadline falls into an iteration at different points, a split
+    // point whose brothers ran out of time must not leave its partial
+    // result in the table. A serial search of the same depth has to
+    // confirm every bound with a null window on it: pruning is off, but
+    // the quiescent search still returns bounds depending on the window.
+    for (int time : {15, 25, 35, 45, 55, 65, 75, 85}) {
+        AIPlayer parallel(board.next_move_color, milliseconds(time));
+        parallel.setThreads(4);
+        parallel.setParallelMode(AIPlayer::YoungBrothersWait);
+        parallel.setPruning(0);
+        Move move = EMPTY_MOVE;
+        AdvancedMoveData advanced;
+        EXPECT_TRUE(parallel.getMove(board, move, &advanced));
+        EXPECT_TRUE(board.isValidMove(board.next_move_color, move));
+        EXPECT_EQ(board.toFEN(), fen);
+
+        // root moves of the aborted iteration have the depth of the last
+        // finished one, shallower entries come from finished iterations
+        TTranspositionTablePtr table = parallel.getTranspositionTable();
+        for (const Move & root_move : moves) {
+            board.move(root_move);
+            TranspositionTable::Entry entry;
+            if (table->probe(board.hash, entry) && entry.depth >= advanced.depth) {
+                auto serialSearch = [this, &entry](int alpha) {
+                    AIPlayer serial(board.next_move_color, entry.depth);
+                    serial.setPruning(0);
+                    EvaluationInformation info;
+                    info.depth = entry.depth;
+                    info.ply   = 1;
+                    info.alpha = alpha;
+                    info.beta  = alpha + 1;
+                    return serial.evalAlphaBeta(board, &info);
+                };
+                if (entry.bound != TranspositionTable::BOUND_UPPER) {
+                    EXPECT_GE(serialSearch(entry.score - 1), entry.score) << root_move.toString() << " after " << time << "ms";
+                }
+                if (entry.bound != TranspositionTable::BOUND_LOWER) {
+                    EXPECT_LE(serialSearch(entry.score), entry.score) << root_move.toString() << " after " << time << "ms";
+                }
+            }
+            board.undoMove(root_move);
+        }
+        EXPECT_EQ(board.toFEN(), fen);
+    }
+}
+void Tests::MoveOrdering()
+{
+    // white queen and pawn can take the black queen, queen and knight
+    // a defended pawn
+    board.loadFEN("4k3/8/5p2/3q2p1/2P1p3/5N2/3Q4/4K3 w - - 0 1");
+    MoveList moves;
+    MoveGenerator<false>::getMoves(board, board.next_move_color, moves, moves);
+    int count = moves.size();
+
+    Move hash_move = *Move::fromString(board, "e1f1");
+    Move killer = *Move::fromString(board, "d2a5");
+    Move good_quiet = *Move::fromString(board, "f3h4");
+
+    SearchHistory history;
+    history.addCutoff(killer, 3, 1);
+    history.addCutoff(good_quiet, 7, 4);
+
+    MovePicker picker(board, hash_move.packed(), &history, 3);
+    vector<Move> order;
+    while (Move * move = picker.next())
+        order.push_back(*move);
+    ASSERT_EQ(static_cast<int>(order.size()), count);
+
+    EXPECT_EQ(order[0], hash_move);
+    // most valuable victim, least valuable attacker
+    EXPECT_EQ(order[1].toString(), "C4D5");
+    EXPECT_EQ(order[2].toString(), "D2D5");
+    // then the killer of the ply and quiet moves by history
+    EXPECT_EQ(order[3], killer);
+    EXPECT_EQ(order[4], good_quiet);
+    // losing captures last
+    EXPECT_EQ(order[count - 2].toString(), "F3G5");
+    EXPECT_EQ(order[count - 1].toString(), "D2G5");
+
+    // a killer which cannot be played here is left out
+    board.loadFEN("4k3/8/8/8/8/8/8/R3K3 w - - 0 1");
+    MoveList rook_moves;
+    MoveGenerator<false>::getMoves(board, board.next_move_color, rook_moves, rook_moves);
+    MovePicker other(board, 0, &history, 3);
+    Move * begin = other.sortRemaining();
+    EXPECT_EQ(other.end() - begin, rook_moves.size());
+}
+void Tests::PerftSuite()
+{
+    for (const Perft::Position & position : Perft::suite()) {
+        board.loadFEN(position.fen);
+        for (int depth = 1; depth <= 3; depth++)
+            EXPECT_EQ(Perft::run(board, depth).nodes, position.nodes[depth - 1]) << position.name << " " << depth;
+        EXPECT_EQ(board.toFEN(), string(position.fen)) << position.name;
+    }
+
+    board.loadFEN("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    PerftCounters counters = Perft::run(board, 3);
+    EXPECT_EQ(counters.captures, 17102u);
+    EXPECT_EQ(counters.en_passants, 45u);
+    EXPECT_EQ(counters.castles, 3162u);
+    EXPECT_EQ(counters.promotions, 0u);
+    EXPECT_EQ(counters.checks, 993u);
+
+    PerftCounters total;
+    auto divided = Perft::divide(board, 3);
+    for (const auto & root : divided)
+        total += root.second;
+    EXPECT_EQ(divided.size(), 48u);
+    EXPECT_EQ(total.nodes, counters.nodes);
+    EXPECT_EQ(total.checks, counters.checks);
+}
+void Tests::TaperedEvaluation()
+{
+    AIPlayer player(WHITE, 1);
+
+    board.initDefaultSetup();
+    EXPECT_EQ(player.evaluateBoard(board), 0);
+
+    // colors swapped and the board mirrored, the side to move sees the same
+    auto mirror = [](const string & fen) {
+        stringstream in(fen), out;
+        string placement, color, castlings, passant, ranks;
+        in >> placement >> color >> castlings >> passant;
+        stringstream rows(placement);
+        for (string row; getline(rows, row, '/'); )
+            ranks = ranks.empty() ? row : row + "/" + ranks;
+        auto swap_case = [](string str) {
+            for (char & c : str)
+                c = isupper(c) ? tolower(c) : toupper(c);
+            return str;
+        };
+        if (passant != "-")
+            passant[1] = passant[1] == '3' ? '6' : '3';
+        out << swap_case(ranks) << (color == "w" ? " b " : " w ") << swap_case(castlings) << " " << passant << " 0 1";
+        return out.str();
+    };
+    for (const char * fen : {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                             "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+                             "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"}) {
+        board.loadFEN(fen);
+        int score = player.evaluateBoard(board);
+        board.loadFEN(mirror(fen));
+        EXPECT_EQ(player.evaluateBoard(board), score) << fen;
+    }
+
+    // a knight is worth more in the center, a king too once the queens are gone
+    board.loadFEN("4k3/8/8/8/3N4/8/8/4K3 w - - 0 1");
+    int centered = player.evaluateBoard(board);
+    board.loadFEN("4k3/8/8/8/8/8/8/N3K3 w - - 0 1");
+    EXPECT_GT(centered, player.evaluateBoard(board));
+
+    board.loadFEN("4k3/pppppppp/8/8/8/8/PPPPPPPP/4K3 w - - 0 1");
+    int king_back = player.evaluateBoard(board);
+    board.loadFEN("4k3/pppppppp/8/8/4K3/8/PPPPPPPP/8 w - - 0 1");
+    EXPECT_GT(player.evaluateBoard(board), king_back);
+}
+void Tests::PawnStructure()
+{
+    auto pawns_score = [this](const char * fen, int phase) {
+        board.loadFEN(fen);
+        int score[2];
+        evaluatePawns(board, score);
+        return score[phase];
+    };
+
+    // both pawns are passed on the one board, on the other the black pawn
+    // stops them and is isolated itself
+    EXPECT_GT(pawns_score("4k3/8/8/8/8/4P3/5P2/4K3 w - - 0 1", ENDGAME),
+              pawns_score("4k3/5p2/8/8/8/4P3/5P2/4K3 w - - 0 1", ENDGAME));
+    // the further, the better
+    EXPECT_GT(pawns_score("4k3/4P3/8/8/8/8/8/4K3 w - - 0 1", ENDGAME),
+              pawns_score("4k3/8/8/8/8/4P3/8/4K3 w - - 0 1", ENDGAME));
+    // doubled and isolated pawns are weak, equal structures are worth 0
+    EXPECT_LT(pawns_score("4k3/pp6/8/8/8/1P6/PP6/4K3 w - - 0 1", MIDGAME), 0);
+    EXPECT_LT(pawns_score("4k3/pp6/8/8/8/8/P1P5/4K3 w - - 0 1", MIDGAME), 0);
+    EXPECT_EQ(pawns_score("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", MIDGAME), 0);
+
+    // the pawn key changes with pawn moves only
+    board.initDefaultSetup();
+    uint64_t pawn_hash = board.pawn_hash;
+    EXPECT_NE(pawn_hash, 0u);
+    board.move(*Move::fromString(board, "g1f3"));
+    EXPECT_EQ(board.pawn_hash, pawn_hash);
+    board.move(*Move::fromString(board, "d7d5"));
+    EXPECT_NE(board.pawn_hash, pawn_hash);
+
+    PawnTable table;
+    int score[2] = {-17, 123}, found[2];
+    EXPECT_FALSE(table.probe(board.pawn_hash, found));
+    table.store(board.pawn_hash, score);
+    EXPECT_TRUE(table.probe(board.pawn_hash, found));
+    EXPECT_EQ(found[MIDGAME], -17);
+    EXPECT_EQ(found[ENDGAME], 123);
+    EXPECT_FALSE(table.probe(pawn_hash, found));
+}
+void Tests::EvaluationCache()
+{
+    EvalCache cache(1);
+    int value = 0;
+    EXPECT_FALSE(cache.probe(12345, value));
+    cache.store(12345, -321);
+    EXPECT_TRUE(cache.probe(12345, value));
+    EXPECT_EQ(value, -321);
+    // same slot, other key
+    EXPECT_FALSE(cache.probe(12345 + (1ULL << 40), value));
+    cache.clear();
+    EXPECT_FALSE(cache.probe(12345, value));
+
+    // a cached evaluation is the one computed, for either side to move
+    AIPlayer player(WHITE, 1);
+    player.setEvalCacheSize(1);
+    board.loadFEN("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+#ifdef PROFILE
+    long long probes = measure_eval_cache.probes, hits = measure_eval_cache.hits;
+#endif
+    int computed = player.evaluateBoard(board);
+    EXPECT_EQ(player.evaluateBoard(board), computed);
+    board.toogleColor();
+    EXPECT_EQ(player.evaluateBoard(board), -computed);
+#ifdef PROFILE
+    EXPECT_EQ(measure_eval_cache.probes - probes, 3);
+    EXPECT_EQ(measure_eval_cache.hits - hits, 1);
+#endif
+
+    // no cache, nothing counted
+    player.setEvalCacheSize(0);
+    EXPECT_EQ(player.evaluateBoard(board), -computed);
+#ifdef PROFILE
+    EXPECT_EQ(measure_eval_cache.probes - probes, 3);
+#endif
+}
+void Tests::Quiescence()
+{
+    // the captures of the quiescent search: taking the defended pawn on d5
+    // loses the queen
+    board.loadFEN("4k3/p7/4p3/3p3p/8/8/8/3QK3 w - - 0 1");
+    MovePicker picker(board);
+    Move * capture = picker.next();
+    ASSERT_TRUE(capture);
+    EXPECT_EQ(capture->toString(), "D1H5");
+    EXPECT_FALSE(picker.next());
+
+    // one ply deep, but the recapture on d5 is seen: the free pawn is taken
+    AIPlayer player(WHITE, 1);
+    Move move;
+    ASSERT_TRUE(player.getMove(board, move));
+    EXPECT_EQ(move.toString(), "D1H5");
+
+    // in check the quiescent search looks at the evasions, a mate is a mate
+    board.loadFEN("6k1/5ppp/8/8/8/8/8/K2R4 w - - 0 1");
+    EvaluationInformation info;
+    info.alpha = -WIN_VALUE;
+    info.beta = WIN_VALUE;
+    board.move(*Move::fromString(board, "d1d8"));
+    EXPECT_LE(player.quiescence(board, &info), -WIN_VALUE + 100);
+}
+void Tests::StaticExchange()
+{
+    auto see = [this](const char * fen, const char * move) {
+        board.loadFEN(fen);
+        return board.staticExchange(*Move::fromString(board, move));
+    };
+
+    // free pawn, pawn defended by a pawn
+    EXPECT_EQ(see("6k1/8/8/4p3/8/8/8/4R1K1 w - - 0 1", "e1e5"), PAWN_VALUE);
+    EXPECT_EQ(see("6k1/8/3p4/4p3/8/8/8/4Q1K1 w - - 0 1", "e1e5"), PAWN_VALUE - QUEEN_VALUE);
+    // the rook behind backs up the first one, without it the rook is lost
+    EXPECT_EQ(see("4r1k1/8/8/4p3/8/8/4R3/4R1K1 w - - 0 1", "e2e5"), PAWN_VALUE);
+    EXPECT_EQ(see("4r1k1/8/8/4p3/8/8/4R3/6K1 w - - 0 1", "e2e5"), PAWN_VALUE - ROOK_VALUE);
+    // the defender does not have to take back
+    EXPECT_EQ(see("4r1k1/8/8/4q3/8/8/4R3/4R1K1 w - - 0 1", "e2e5"), QUEEN_VALUE);
+    // the king cannot take a defended figure
+    EXPECT_EQ(see("8/8/8/4k3/3p4/8/1B6/3R2K1 w - - 0 1", "b2d4"), PAWN_VALUE);
+    EXPECT_EQ(see("8/8/8/4k3/3p4/8/1B6/6K1 w - - 0 1", "b2d4"), PAWN_VALUE - BISHOP_VALUE);
+    // en passant
+    EXPECT_EQ(see("6k1/8/8/3pP3/8/8/8/6K1 w - d6 0 1", "e5d6"), PAWN_VALUE);
+
+    // both colors, sliders blocked
+    board.loadFEN("4r1k1/8/8/4p3/3P4/8/4R3/4R1K1 w - - 0 1");
+    EXPECT_EQ(board.attackersTo(E5, board.occupied_bb), BIT(E8) | BIT(E2) | BIT(D4));
+}
+void Tests::SelectiveSearch()
+{
+    // a null move only passes the turn, the en passant right is gone with it
+    board.loadFEN("4k3/8/8/3pP3/8/8/8/R3K3 w - d6 0 1");
+    uint64_t hash = board.hash;
+    board.makeNullMove();
+    EXPECT_EQ(board.next_move_color, BLACK);
+    EXPECT_EQ(board.passant_pos, -1);
+    EXPECT_EQ(board.hash, board.computeHash());
+    board.undoNullMove();
+    EXPECT_EQ(board.next_move_color, WHITE);
+    EXPECT_EQ(board.passant_pos, D5);
+    EXPECT_EQ(board.hash, hash);
+
+    // direct checks, uncovered ones, none
+    board.loadFEN("4k3/8/8/8/4N3/8/8/R3K2B w - - 0 1");
+    EXPECT_TRUE(board.givesCheck(*Move::fromString(board, "a1a8")));
+    EXPECT_TRUE(board.givesCheck(*Move::fromString(board, "e4d6")));
+    EXPECT_FALSE(board.givesCheck(*Move::fromString(board, "a1a7")));
+    board.loadFEN("4k3/8/8/8/8/8/4B3/4R1K1 w - - 0 1");
+    EXPECT_TRUE(board.givesCheck(*Move::fromString(board, "e2a6")));
+    EXPECT_FALSE(board.givesCheck(*Move::fromString(board, "g1f1")));
+
+    // every technique on its own and all of them together find the mate
+    for (int pruning : {0, int(AIPlayer::NullMove), int(AIPlayer::LateMoveReductions), int(AIPlayer::Futility),
+                        int(AIPlayer::ReverseFutility), int(AIPlayer::AllPruning)}) {
+        board.loadFEN("6k1/8/6K1/8/1B6/8/8/3B4 w - - 2 3");
+        AIPlayer player(WHITE, 4);
+        player.setPruning(pruning);
+        EXPECT_EQ(player.getPruning(), pruning);
+        Move move;
+        AdvancedMoveData advanced;
+        ASSERT_TRUE(player.getMove(board, move, &advanced));
+        EXPECT_EQ(move.toString(), "D1B3") << pruning;
+        EXPECT_GT(advanced.board_evaluation, WIN_VALUE / 2) << pruning;
+    }
+}
+void Tests::Repetition()
+{
+    board.initDefaultSetup();
+    auto play = [this](std::initializer_list<const char *> moves) {
+        for (const char * str : moves)
+            board.move(*Move::fromString(board, str));
+    };
+
+    play({"g1f3", "g8f6", "f3g1"});
+    EXPECT_FALSE(board.isRepetition());
+    play({"f6g8"});
+    EXPECT_TRUE(board.isRepetition());
+    EXPECT_FALSE(board.isRepetition(2));
+    EXPECT_EQ(board.getPlayerStatus(WHITE), ChessPlayer::Normal);
+
+    // the third time is a draw
+    play({"g1f3", "g8f6", "f3g1", "f6g8"});
+    EXPECT_TRUE(board.isRepetition(2));
+    EXPECT_EQ(board.getPlayerStatus(WHITE), ChessPlayer::Draw);
+
+    // nothing before a pawn move comes back
+    play({"e2e4", "g8f6", "g1f3", "f6g8", "f3g1"});
+    EXPECT_FALSE(board.isRepetition());
+
+    // the search scores a repeated position as a draw
+    AIPlayer player(WHITE, 3);
+    EvaluationInformation info;
+    info.depth = 3;
+    info.alpha = -WIN_VALUE;
+    info.beta = WIN_VALUE;
+    board.loadFEN("4k3/8/8/8/8/8/Q7/4K3 w - - 0 1");
+    play({"a2a3", "e8d8", "a3a2", "d8e8"});
+    EXPECT_EQ(player.evalAlphaBeta(board, &info), 0);
+}
+void Tests::CopyMake()
+{
+    auto expect_same = [this](const CompactPosition & position, const std::string & moves) {
+        EXPECT_EQ(position.hash, board.hash) << moves;
+        EXPECT_EQ(position.pawn_hash, board.pawn_hash) << moves;
+        EXPECT_EQ(position.psq_score[MIDGAME], board.psq_score[MIDGAME]) << moves;
+        EXPECT_EQ(position.psq_score[ENDGAME], board.psq_score[ENDGAME]) << moves;
+        EXPECT_EQ(position.color_bb[0], board.color_bb[0]) << moves;
+        EXPECT_EQ(position.color_bb[1], board.color_bb[1]) << moves;
+        for (int figure = PAWN; figure <= KING; figure++)
+            EXPECT_EQ(position.figures_bb[figure], board.figures_bb[0][figure] | board.figures_bb[1][figure]) << moves;
+        EXPECT_EQ(position.castling_rights, board.castlingRights()) << moves;
+        EXPECT_EQ(position.passant_pos, board.passant_pos) << moves;
+        EXPECT_EQ(position.king_pos[0], board.white_king_pos) << moves;
+        EXPECT_EQ(position.king_pos[1], board.black_king_pos) << moves;
+        EXPECT_EQ(position.next_move_color, board.next_move_color) << moves;
+        EXPECT_EQ(position.non_pawn_kick_moves_count, board.non_pawn_kick_moves_count) << moves;
+    };
+
+    // castling both ways, en passant, promotions with and without capture
+    for (const char * fen : {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                             "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+                             "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"}) {
+        board.loadFEN(fen);
+        CompactPosition root = CompactPosition::fromBoard(board);
+        expect_same(root, fen);
+
+        MoveList moves;
+        MoveGenerator<false>::getMoves(board, board.next_move_color, moves, moves);
+        for (Move & move : moves) {
+            board.move(move);
+            CompactPosition child = root;
+            child.makeMove(move);
+            expect_same(child, move.toString());
+
+            MoveList replies;
+            MoveGenerator<false>::getMoves(board, board.next_move_color, replies, replies);
+            for (Move & reply : replies) {
+                board.move(reply);
+                CompactPosition grandchild = child;
+                grandchild.makeMove(reply);
+                expect_same(grandchild, move.toString() + reply.toString());
+                board.undoMove(reply);
+            }
+            board.undoMove(move);
+        }
+        // the parent copy is untouched
+        expect_same(root, fen);
+        EXPECT_EQ(root.figureAt(board.white_king_pos), KING);
+    }
+}
+void Tests::ConcurrentGames()
+{
+    const char * openings[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    };
+    const int plies = 6;
+
+    // every game on its own thread with its own players
+    std::vector<std::thread> games;
+    std::vector<int> played(4, 0);
+    for (int i = 0; i < 4; i++) {
+        games.emplace_back([&openings, &played, plies, i]() {
+            ChessBoard game;
+            game.loadFEN(openings[i]);
+            AIPlayer white(WHITE, 3), black(BLACK, 3);
+            for (int ply = 0; ply < plies; ply++) {
+                AIPlayer & player = game.next_move_color == WHITE ? white : black;
+                Move move = EMPTY_MOVE;
+                if (NOT player.getMove(game, move))
+                    break;
+                game.move(move);
+                played[i]++;
+            }
+        });
+    }
+
+    // players searching one board at once leave it as it is
+    board.loadFEN(openings[1]);
+    string fen = board.toFEN();
+    AdvancedMoveData expected;
+    Move move = EMPTY_MOVE;
+    EXPECT_TRUE(AIPlayer(board.next_move_color, 4).getMove(board, move, &expected));
+
+    std::vector<AdvancedMoveData> shared(2);
+    std::vector<std::thread> searches;
+    for (int i = 0; i < 2; i++) {
+        searches.emplace_back([this, &shared, i]() {
+            Move shared_move = EMPTY_MOVE;
+            AIPlayer(board.next_move_color, 4).getMove(board, shared_move, &shared[i]);
+        });
+    }
+    for (std::thread & search : searches)
+        search.join();
+    for (std::thread & game : games)
+        game.join();
+
+    for (int i = 0; i < 4; i++)
+        EXPECT_EQ(played[i], plies) << openings[i];
+    for (const AdvancedMoveData & data : shared)
+        EXPECT_EQ(data.board_evaluation, expected.board_evaluation);
+    EXPECT_EQ(board.toFEN(), fen);
+}
+void Tests::AsyncGames()
+{
+    auto io = std::make_shared<boost::asio::io_service>();
+    auto pool = std::make_shared<ComputePool>(2, 1);
+    auto metrics = std::make_shared<GameMetrics>();
+    EXPECT_EQ(pool->size(), 2);
+
+    // short games from the start, a mate in one and a game cancelled
+    // in the middle of an endless search
+    const int count = 8;
+    std::vector<std::unique_ptr<AsyncGame>> games;
+    for (int i = 0; i < count; i++) {
+        games.emplace_back(new AsyncGame(io, std::make_shared<AsyncAiPlayer>(WHITE, 2, pool),
+                                         std::make_shared<AsyncAiPlayer>(BLACK, 2, pool)));
+        games.back()->setMaxPlies(6);
+        games.back()->setMetrics(metrics);
+    }
+    games[0]->loadFEN("6k1/5ppp/8/8/8/8/8/K2R4 w - - 0 1");
+    auto endless = std::make_shared<AsyncAiPlayer>(BLACK, MAX_SEARCH_DEPTH, pool);
+    AsyncGame cancelled(io, std::make_shared<AsyncAiPlayer>(WHITE, 1, pool), endless);
+
+    std::vector<AsyncPlayer::EndStatus> results(count, AsyncPlayer::NONE);
+    std::atomic<int> running(count + 1);
+    for (int i = 0; i < count; i++) {
+        games[i]->start([&results, &running, i](AsyncPlayer::EndStatus status) {
+            results[i] = status;
+            running--;
+        });
+    }
+    AsyncPlayer::EndStatus cancelled_status = AsyncPlayer::DRAW;
+    cancelled.start([&cancelled_status, &running](AsyncPlayer::EndStatus status) {
+        cancelled_status = status;
+        running--;
+    });
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 2; i++) {
+        threads.emplace_back([io]() {
+            io->run();
+        });
+    }
+    // by now white has moved and the endless search is on
+    while (running > 1)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // resizing the table of one player leaves the one the endless search
+    // probes alone
+    auto resized = std::make_shared<AsyncAiPlayer>(WHITE, 2, pool);
+    resized->getAiPlayer().setHashSize(2);
+    EXPECT_NE(resized->getAiPlayer().getTranspositionTable(), endless->getAiPlayer().getTranspositionTable());
+    EXPECT_EQ(resized->getAiPlayer().getTranspositionTable()->getSizeMb(), 2u);
+    EXPECT_EQ(endless->getAiPlayer().getTranspositionTable()->getSizeMb(), 1u);
+    cancelled.cancel();
+    for (std::thread & thread : threads)
+        thread.join();
+
+    EXPECT_EQ(running, 0);
+    EXPECT_EQ(results[0], AsyncPlayer::WHITE_WIN);
+    EXPECT_EQ(games[0]->getPlies(), 1);
+    for (int i = 1; i < count; i++) {
+        EXPECT_EQ(results[i], AsyncPlayer::DRAW);
+        EXPECT_EQ(games[i]->getPlies(), 6);
+    }
+    EXPECT_EQ(cancelled_status, AsyncPlayer::NONE);
+    EXPECT_EQ(cancelled.getPlies(), 1);
+
+    EXPECT_EQ(metrics->games_started, count);
+    EXPECT_EQ(metrics->games_finished, count);
+    EXPECT_EQ(metrics->moves, 1 + 6 * (count - 1));
+    EXPECT_EQ(metrics->move_latency.count(), metrics->moves);
+    EXPECT_LE(metrics->move_latency.percentile(0.5), metrics->move_latency.max());
+
+    // the cancelled search stops soon
+    for (int i = 0; i < 500 && pool->pending() > 0; i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(pool->pending(), 0);
+
+    // cancelling an idle player does not cut its next search short
+    auto idle = std::make_shared<AsyncAiPlayer>(WHITE, 4, pool);
+    idle->cancel();
+    board.initDefaultSetup();
+    std::promise<Move> reply;
+    idle->asyncGetNext(board, [&reply](const Move & move) {
+        reply.set_value(move);
+    });
+    Move move = reply.get_future().get();
+    EXPECT_TRUE(board.isValidMove(WHITE, move));
+    EXPECT_EQ(idle->getLastMoveData().depth, 4);
+}
+void Tests::AsyncGamesOwnTables()
+{
+    auto io = std::make_shared<boost::asio::io_service>();
+    auto pool = std::make_shared<ComputePool>(1, 1);
+
+    // two games on one pool, every player with a table of its own
+    auto white = std::make_shared<AsyncAiPlayer>(WHITE, 2, pool);
+    auto black = std::make_shared<AsyncAiPlayer>(BLACK, 2, pool);
+    auto other_white = std::make_shared<AsyncAiPlayer>(WHITE, 2, pool);
+    auto other_black = std::make_shared<AsyncAiPlayer>(BLACK, 2, pool);
+    TTranspositionTablePtr table = white->getAiPlayer().getTranspositionTable();
+    EXPECT_NE(table, black->getAiPlayer().getTranspositionTable());
+    EXPECT_NE(table, other_white->getAiPlayer().getTranspositionTable());
+    EXPECT_NE(table, other_black->getAiPlayer().getTranspositionTable());
+
+    AsyncGame game(io, white, black);
+    game.setMaxPlies(2);
+    game.start([](AsyncPlayer::EndStatus) {});
+    io->run();
+    EXPECT_EQ(game.getPlies(), 2);
+    while (pool->pending() > 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    // a deep result of the last search of white in the first game
+    TranspositionTable::Entry entry;
+    uint64_t key = 0x123456789abcdef0ULL;
+    table->store(key, 5, TranspositionTable::BOUND_LOWER, 0, 0);
+
+    AsyncGame other(io, other_white, other_black);
+    other.setMaxPlies(6);
+    other.start([](AsyncPlayer::EndStatus) {});
+    io->reset();
+    io->run();
+    EXPECT_EQ(other.getPlies(), 6);
+    while (pool->pending() > 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    // the searches of the other game have not aged it, a shallow bound
+    // still does not replace it
+    table->store(key, 2, TranspositionTable::BOUND_UPPER, 10, 0);
+    ASSERT_TRUE(table->probe(key, entry));
+    EXPECT_EQ(entry.depth, 5);
+}
+void Tests::LegalMoves()
+{
+    auto count_moves = [this]() {
+        MoveList moves;
+        MoveGenerator<false>::getMoves(board, board.next_move_color, moves, moves);
+        return moves.size();
+    };
+    auto valid = [this](const char * str) {
+        return static_cast<bool>(Move::fromString(board, str));
+    };
+
+    // the bishop is pinned on the file, the king has four squares
+    board.loadFEN("4k3/4r3/8/8/8/8/4B3/4K3 w - - 0 1");
+    EXPECT_EQ(count_moves(), 4);
+    EXPECT_FALSE(valid("e2d3"));
+    EXPECT_TRUE(valid("e1d2"));
+
+    // in check the knight may only block, the king does not hide behind itself
+    board.loadFEN("4k3/8/8/8/8/8/3N4/r3K3 w - - 0 1");
+    EXPECT_EQ(count_moves(), 3);
+    EXPECT_TRUE(valid("d2b1"));
+    EXPECT_FALSE(valid("e1f1"));
+    EXPECT_FALSE(valid("d2f3"));
+
+    // double check, only the king moves
+    board.loadFEN("4k3/8/8/8/1b6/8/4r3/3NKN2 w - - 0 1");
+    EXPECT_FALSE(valid("f1e3"));
+    EXPECT_TRUE(valid("e1e2"));
+    EXPECT_EQ(count_moves(), 1);
+
+    // en passant would open the rank to the rook
+    board.loadFEN("8/8/8/K2pP2r/8/8/8/7k w - d6 0 1");
+    EXPECT_FALSE(valid("e5d6"));
+    EXPECT_TRUE(valid("e5e6"));
+
+    // en passant takes the checking pawn
+    board.loadFEN("8/8/8/2k5/3Pp3/8/8/4K3 b - d3 0 1");
+    EXPECT_TRUE(valid("e4d3"));
+    EXPECT_FALSE(valid("e4e3"));
+    EXPECT_EQ(board.getPlayerStatus(board.next_move_color), ChessPlayer::InCheck);
+}
 void Tests::TestFenNegative()
 {
     ChessBoard board;
@@ -213,7 +1161,6 @@ void Tests::CheckPassant()
     move2.from = E7;
     move2.to = E6;
     move2.figure = board.square[move2.from];
-    move2.passant_pos_opponent = E4;
 
     board.move(move2);
 
@@ -272,7 +1219,11 @@ void Tests::TestMoveFromStringPositive() {
 
     move = Move::fromString(board, "E7E5");
     EXPECT_TRUE(move);
-    EXPECT_EQ(move->passant_pos_opponent, E4);
+
+    // passant position is restored when the reply is taken back
+    board.move(*move);
+    board.undoMove(*move);
+    EXPECT_EQ(board.passant_pos, E4);
 
 }
 
@@ -333,7 +1284,6 @@ void Tests::TestFen()
     Move move = EMPTY_MOVE;
     move.from = F4;
     move.to = F3;
-    move.passant_pos_opponent = E4;
     move.figure = board.square[F4];
 
     board.move(move);
@@ -392,4 +1342,119 @@ TEST(WrongAppearingFigures, _)
     Tests tests;
     tests.WrongAppearingFigures();
 }
+TEST(BitBoards, InSync)
+{
+    Tests tests;
+    tests.BitBoardsInSync();
+}
+TEST(BitBoards, SlidingAttacks)
+{
+    Tests tests;
+    tests.SlidingAttacks();
+}
+TEST(PackedMoves, RoundTrip)
+{
+    Tests tests;
+    tests.PackedMoves();
+}
+TEST(Zobrist, Incremental)
+{
+    Tests tests;
+    tests.ZobristHash();
+}
 
+TEST(TranspositionTable, Entries)
+{
+    Tests tests;
+    tests.TranspositionTableEntries();
+}
+TEST(TimeBudget, _)
+{
+    Tests tests;
+    tests.TimeBudget();
+}
+TEST(LazySmp, _)
+{
+    Tests tests;
+    tests.LazySmp();
+}
+TEST(SplitPoints, _)
+{
+    Tests tests;
+    tests.SplitPoints();
+}
+TEST(SplitPoints, Deadline)
+{
+    Tests tests;
+    tests.SplitPointsDeadline();
+}
+TEST(MoveOrdering, _)
+{
+    Tests tests;
+    tests.MoveOrdering();
+}
+TEST(Perft, Suite)
+{
+    Tests tests;
+    tests.PerftSuite();
+}
+TEST(LegalMoves, _)
+{
+    Tests tests;
+    tests.LegalMoves();
+}
+TEST(TaperedEvaluation, _)
+{
+    Tests tests;
+    tests.TaperedEvaluation();
+}
+TEST(PawnStructure, _)
+{
+    Tests tests;
+    tests.PawnStructure();
+}
+TEST(EvaluationCache, _)
+{
+    Tests tests;
+    tests.EvaluationCache();
+}
+TEST(Quiescence, _)
+{
+    Tests tests;
+    tests.Quiescence();
+}
+TEST(StaticExchange, _)
+{
+    Tests tests;
+    tests.StaticExchange();
+}
+TEST(SelectiveSearch, _)
+{
+    Tests tests;
+    tests.SelectiveSearch();
+}
+TEST(Repetition, _)
+{
+    Tests tests;
+    tests.Repetition();
+}
+TEST(CopyMake, _)
+{
+    Tests tests;
+    tests.CopyMake();
+}
+TEST(ConcurrentGames, _)
+{
+    Tests tests;
+    tests.ConcurrentGames();
+}
+TEST(AsyncGames, _)
+{
+    Tests tests;
+    tests.AsyncGames();
+}
+TEST(AsyncGames, OwnTables)
+{
+    Tests tests;
+    tests.AsyncGamesOwnTables();
+}
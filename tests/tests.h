@@ -15,6 +15,29 @@ public:
     void TestAdvanced();
     void FiguresCount();
     void WrongAppearingFigures();
+    void BitBoardsInSync();
+    void SlidingAttacks();
+    void PackedMoves();
+    void ZobristHash();
+    void TranspositionTableEntries();
+    void TimeBudget();
+    void LazySmp();
+    void SplitPoints();
+    void SplitPointsDeadline();
+    void MoveOrdering();
+    void PerftSuite();
+    void TaperedEvaluation();
+    void LegalMoves();
+    void PawnStructure();
+    void EvaluationCache();
+    void Quiescence();
+    void StaticExchange();
+    void SelectiveSearch();
+    void Repetition();
+    void CopyMake();
+    void ConcurrentGames();
+    void AsyncGames();
+    void AsyncGamesOwnTables();
 
     void TestMoveFromStringPositive();
     void TestMoveFromStringNegative();